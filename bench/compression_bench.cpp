@@ -0,0 +1,154 @@
+// compression_bench.cpp
+//
+// Storage saved and decode throughput of compressed message bodies, for
+// synthetic log and code pastes written through ChatDatabaseHandler:
+// qCompress per row, and zlib with a shared dictionary trained on the
+// first tenth of the messages (when built with zlib).
+//
+//     quickchat_compression_bench [messages] [threshold]    (default 5000, 512)
+#include <QCoreApplication>
+#include <QRandomGenerator>
+#include <QTemporaryDir>
+#include <QDir>
+#include <QDebug>
+
+#include "../setup_db.h"
+#include "../chatdbhandler.h"
+
+namespace {
+
+const QStringList codeLines = {
+    "    if (!query.exec()) {",
+    "        qDebug() << \"Query failed:\" << query.lastError().text();",
+    "        return false;",
+    "    }",
+    "    for (const auto &row : rows) {",
+    "    QSqlQuery query(db);",
+    "    query.bindValue(\":id\", id);",
+    "}",
+    "#include <QString>",
+    "    return result;",
+};
+
+const QStringList logLevels = {"INFO ", "DEBUG", "WARN ", "ERROR"};
+const QStringList logPaths = {"/api/v1/messages", "/api/v1/groups", "/api/v1/users/me", "/health"};
+
+// A pasted log excerpt or code block of 20 to 80 lines
+QString pastedMessage(QRandomGenerator &random)
+{
+    QStringList lines;
+    int count = 20 + random.bounded(61);
+    if (random.bounded(2) == 0) {
+        for (int i = 0; i < count; ++i) {
+            lines.append(QString("2024-05-%1T12:%2:%3.%4Z %5 [worker-%6] request handled path=%7 status=%8 duration_ms=%9")
+                             .arg(1 + random.bounded(28), 2, 10, QChar('0'))
+                             .arg(random.bounded(60), 2, 10, QChar('0'))
+                             .arg(random.bounded(60), 2, 10, QChar('0'))
+                             .arg(random.bounded(1000), 3, 10, QChar('0'))
+                             .arg(logLevels[random.bounded(int(logLevels.size()))])
+                             .arg(random.bounded(8))
+                             .arg(logPaths[random.bounded(int(logPaths.size()))])
+                             .arg(random.bounded(10) == 0 ? 500 : 200)
+                             .arg(random.bounded(400)));
+        }
+    } else {
+        lines.append(QString("bool Handler::method%1(int id)").arg(random.bounded(100)));
+        lines.append("{");
+        for (int i = 0; i < count; ++i) {
+            lines.append(codeLines[random.bounded(int(codeLines.size()))]);
+        }
+    }
+    return lines.join('\n');
+}
+
+struct Result {
+    ChatDatabaseHandler::CompressionReport report;
+    int dictionaryId;
+};
+
+// Writes `messages` pastes into a fresh database with the given threshold
+bool run(int messages, int threshold, bool dictionary, Result *result)
+{
+    QTemporaryDir dir;
+    QDir::setCurrent(dir.path());
+    if (setup_chat_db() != 0) {
+        return false;
+    }
+
+    ConnectionProfile profile = ConnectionProfile::fast();
+    profile.compressAbove = threshold;
+    profile.compressionDictionary = dictionary;
+
+    ChatDatabaseHandler handler;
+    handler.setConnectionName(QString("bench_%1_%2").arg(threshold).arg(dictionary));
+    handler.setConnectionProfile(profile);
+    if (!handler.initialize()) {
+        return false;
+    }
+
+    // Same corpus for every run
+    QRandomGenerator random(42);
+    result->dictionaryId = -1;
+    handler.beginTransaction();
+    for (int i = 0; i < messages; ++i) {
+        if (dictionary && i == messages / 10) {
+            handler.commitTransaction();
+            result->dictionaryId = handler.trainCompressionDictionary();
+            handler.beginTransaction();
+        }
+        if (handler.insertGroupMessage("alice@gmail.com", 1, pastedMessage(random), "user") < 0) {
+            handler.rollbackTransaction();
+            return false;
+        }
+    }
+    handler.commitTransaction();
+
+    result->report = handler.compressionReport();
+    QDir::setCurrent(QCoreApplication::applicationDirPath());
+    return true;
+}
+
+void print(const QString &name, const Result &result)
+{
+    const ChatDatabaseHandler::CompressionReport &report = result.report;
+    double saved = report.plainBytes > 0 ? 100.0 * (report.plainBytes - report.storedBytes) / report.plainBytes : 0;
+    double throughput = report.decodeNsecs > 0 ? report.plainBytes * 1000.0 / report.decodeNsecs : 0;  // MB/s
+    qDebug().noquote() << QString("%1: %2 compressed rows, %3 KiB stored for %4 KiB of text (%5% saved), decode %6 MB/s")
+                              .arg(name, -22)
+                              .arg(report.compressedRows)
+                              .arg(report.storedBytes / 1024)
+                              .arg(report.plainBytes / 1024)
+                              .arg(saved, 0, 'f', 1)
+                              .arg(throughput, 0, 'f', 1);
+}
+
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+
+    int messages = argc > 1 ? QString(argv[1]).toInt() : 5000;
+    int threshold = argc > 2 ? QString(argv[2]).toInt() : 512;
+
+    Result plain;
+    if (!run(messages, threshold, false, &plain)) {
+        return 1;
+    }
+    print("qCompress", plain);
+
+    if (!MessageCodec::dictionarySupported()) {
+        qDebug() << "Built without zlib, skipping the shared dictionary run";
+        return 0;
+    }
+
+    Result shared;
+    if (!run(messages, threshold, true, &shared)) {
+        return 1;
+    }
+    if (shared.dictionaryId < 0) {
+        qDebug() << "No dictionary could be trained";
+    }
+    print("zlib + shared dictionary", shared);
+    return 0;
+}
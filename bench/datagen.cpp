@@ -0,0 +1,66 @@
+// datagen.cpp
+//
+// Generates a chat_database.db of any size for benchmarks and profiling,
+// with the model described in datagenerator.h. The rows are written
+// through bulk_build_chat_db() (setup_db.h), then the schema migrations
+// build the indexes.
+//
+//     quickchat_datagen --users 100000 --days 90 --output big.db
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QDateTime>
+#include <QTimeZone>
+#include <QDebug>
+
+#include "datagenerator.h"
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Generates a deterministic QuickChat database.");
+    parser.addHelpOption();
+    QCommandLineOption outputOption("output", "Database file to create.", "file", "chat_database.db");
+    QCommandLineOption seedOption("seed", "Random seed.", "n", "1");
+    QCommandLineOption usersOption("users", "Number of users.", "n", "1000");
+    QCommandLineOption groupsOption("groups", "Number of groups (default users / 10).", "n");
+    QCommandLineOption zipfOption("zipf", "Zipf exponent of the group sizes.", "s", "1.1");
+    QCommandLineOption rateOption("rate", "Messages per user per day.", "n", "20");
+    QCommandLineOption daysOption("days", "Days of history.", "n", "30");
+    QCommandLineOption directOption("direct", "Share of direct messages.", "fraction", "0.3");
+    QCommandLineOption lengthOption("length", "Median message length in characters.", "n", "40");
+    QCommandLineOption sigmaOption("length-sigma", "Spread of the log-normal message length.", "s", "1.0");
+    QCommandLineOption endOption("end", "Date the history ends, yyyy-MM-dd or \"now\".", "date", "2024-06-01");
+    parser.addOptions({outputOption, seedOption, usersOption, groupsOption, zipfOption, rateOption,
+                       daysOption, directOption, lengthOption, sigmaOption, endOption});
+    parser.process(app);
+
+    DataGenOptions options;
+    options.seed = parser.value(seedOption).toUInt();
+    options.users = parser.value(usersOption).toLongLong();
+    options.groups = parser.isSet(groupsOption) ? parser.value(groupsOption).toLongLong() : options.users / 10;
+    options.zipf = parser.value(zipfOption).toDouble();
+    options.rate = parser.value(rateOption).toDouble();
+    options.days = parser.value(daysOption).toInt();
+    options.direct = parser.value(directOption).toDouble();
+    options.length = parser.value(lengthOption).toDouble();
+    options.lengthSigma = parser.value(sigmaOption).toDouble();
+    options.end = parser.value(endOption) == "now"
+                      ? QDateTime::currentDateTime()
+                      : QDateTime(QDate::fromString(parser.value(endOption), "yyyy-MM-dd"), QTime(0, 0), QTimeZone::UTC);
+
+    if (options.users < 2 || options.groups < 0 || options.days < 0 || options.length < 1 || !options.end.isValid()) {
+        qDebug() << "Need at least two users, a valid end date and a message length of at least 1";
+        return 1;
+    }
+
+    qDebug().noquote() << QString("Generating %1 users, %2 groups and about %3 messages into %4")
+                              .arg(options.users)
+                              .arg(options.groups)
+                              .arg(options.expectedMessages())
+                              .arg(parser.value(outputOption));
+    return bulk_build_chat_db(parser.value(outputOption), [&](BulkInserter &inserter) {
+        return generateChatData(inserter, options);
+    });
+}
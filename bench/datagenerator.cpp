@@ -0,0 +1,160 @@
+#include "datagenerator.h"
+
+#include <QRandomGenerator>
+#include <QTimeZone>
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+#include <vector>
+
+namespace {
+
+// The demo accounts come first so the generated database can be logged into
+const QStringList demoNames = {"Alice", "Bob", "Charlie", "Diana", "Evan"};
+
+const QStringList words = {
+    "the", "a", "to", "and", "of", "in", "is", "it", "for", "on", "that", "you", "this", "with",
+    "we", "I", "be", "have", "are", "not", "can", "just", "do", "so", "but", "will", "what",
+    "meeting", "build", "release", "today", "tomorrow", "lunch", "coffee", "deploy", "review",
+    "thanks", "sure", "ok", "later", "fixed", "broken", "test", "query", "database", "slow",
+    "merge", "branch", "ticket", "weekend", "idea", "question", "update", "call", "now",
+};
+
+// Members of a group are `size` distinct users, offset + i * step (mod
+// users) with step coprime to users, so they never have to be stored
+struct Group {
+    qint64 size;
+    qint64 offset;
+    qint64 step;
+
+    qint64 member(qint64 i, qint64 users) const { return (offset + i * step) % users + 1; }
+};
+
+// Standard normal variate (Box-Muller), so the lengths don't depend on the
+// standard library's distributions
+double normal(QRandomGenerator &random)
+{
+    double u = 1.0 - random.generateDouble();
+    double v = random.generateDouble();
+    return std::sqrt(-2.0 * std::log(u)) * std::cos(6.283185307179586 * v);
+}
+
+QString messageText(QRandomGenerator &random, const DataGenOptions &options)
+{
+    int target = int(std::exp(std::log(options.length) + options.lengthSigma * normal(random)));
+    target = std::clamp(target, 1, 4000);
+
+    QString text;
+    text.reserve(target + 16);
+    while (text.size() < target) {
+        if (!text.isEmpty()) {
+            text.append(' ');
+        }
+        text.append(words[random.bounded(int(words.size()))]);
+    }
+    return text;
+}
+
+std::vector<Group> makeGroups(QRandomGenerator &random, const DataGenOptions &options)
+{
+    std::vector<Group> groups;
+    groups.reserve(size_t(options.groups));
+    for (qint64 k = 1; k <= options.groups; ++k) {
+        qint64 size = qint64(std::ceil(double(options.users) / std::pow(double(k), options.zipf)));
+        Group group;
+        group.size = std::clamp<qint64>(size, 2, options.users);
+        group.offset = qint64(random.bounded(quint64(options.users)));
+        do {
+            group.step = 1 + qint64(random.bounded(quint64(options.users)));
+        } while (std::gcd(group.step, options.users) != 1);
+        groups.push_back(group);
+    }
+    return groups;
+}
+
+}
+
+DataGenOptions DataGenOptions::defaults()
+{
+    DataGenOptions options;
+    options.seed = 1;
+    options.users = 1000;
+    options.groups = options.users / 10;
+    options.zipf = 1.1;
+    options.rate = 20;
+    options.days = 30;
+    options.direct = 0.3;
+    options.length = 40;
+    options.lengthSigma = 1.0;
+    options.end = QDateTime(QDate(2024, 6, 1), QTime(0, 0), QTimeZone::UTC);
+    return options;
+}
+
+bool generateChatData(BulkInserter &inserter, const DataGenOptions &options)
+{
+    QRandomGenerator random(options.seed);
+    const qint64 endMsecs = options.end.toMSecsSinceEpoch();
+    const qint64 startMsecs = endMsecs - qint64(options.days) * 24 * 3600 * 1000;
+
+    for (qint64 id = 1; id <= options.users; ++id) {
+        QString name = id <= demoNames.size() ? demoNames[id - 1] : QString("User %1").arg(id);
+        QString email = id <= demoNames.size() ? demoNames[id - 1].toLower() + "@gmail.com"
+                                               : QString("user%1@example.com").arg(id);
+        if (!inserter.insert("user", {id, name, email, "123"})) {
+            return false;
+        }
+    }
+
+    const std::vector<Group> groups = makeGroups(random, options);
+    // In UTC, so a seed gives the same rows on every machine
+    const QString createdAt = QDateTime::fromMSecsSinceEpoch(startMsecs, QTimeZone::UTC).toString("yyyy-MM-dd hh:mm:ss");
+    for (qint64 k = 0; k < qint64(groups.size()); ++k) {
+        const Group &group = groups[size_t(k)];
+        if (!inserter.insert("group", {k + 1, QString("Group %1").arg(k + 1), createdAt, group.member(0, options.users)})) {
+            return false;
+        }
+        for (qint64 i = 0; i < group.size; ++i) {
+            if (!inserter.insert("member", {group.member(i, options.users), k + 1})) {
+                return false;
+            }
+        }
+    }
+
+    // Groups are picked in proportion to their size
+    std::vector<qint64> cumulative(groups.size());
+    qint64 total = 0;
+    for (size_t k = 0; k < groups.size(); ++k) {
+        total += groups[k].size;
+        cumulative[k] = total;
+    }
+
+    const double messages = double(options.users) * options.rate * options.days;
+    const double meanGap = messages > 0 ? (endMsecs - startMsecs) / messages : 0;
+    double time = double(startMsecs);
+    for (qint64 id = 1; meanGap > 0; ++id) {
+        time += -std::log(1.0 - random.generateDouble()) * meanGap;
+        if (time >= endMsecs) {
+            break;
+        }
+
+        QVariant groupId;
+        QVariant recipientId;
+        qint64 sender;
+        if (groups.empty() || random.generateDouble() < options.direct) {
+            sender = 1 + qint64(random.bounded(quint64(options.users)));
+            qint64 recipient = 1 + qint64(random.bounded(quint64(options.users - 1)));
+            recipientId = recipient >= sender ? recipient + 1 : recipient;
+        } else {
+            qint64 pick = qint64(random.bounded(quint64(total)));
+            size_t k = size_t(std::upper_bound(cumulative.begin(), cumulative.end(), pick) - cumulative.begin());
+            const Group &group = groups[k];
+            sender = group.member(qint64(random.bounded(quint64(group.size))), options.users);
+            groupId = qint64(k + 1);
+        }
+
+        if (!inserter.insert("message", {id, sender, groupId, recipientId, messageText(random, options), qint64(time)})) {
+            return false;
+        }
+    }
+    return true;
+}
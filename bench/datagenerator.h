@@ -0,0 +1,46 @@
+// datagenerator.h
+//
+// Deterministic chat data for benchmarks and profiling. The same options
+// and seed always give the same users, groups, members and messages:
+//
+// - group sizes follow a Zipf distribution: the k-th largest group has
+//   users / k^zipf members (at least two), so there are a few huge groups
+//   and a long tail of small ones
+// - every user sends `rate` messages a day on average, over `days` days up
+//   to `end`; arrivals are a Poisson process, so ids and timestamps rise
+//   together as they do in a real database
+// - a `direct` share of the messages are direct messages, the rest go to
+//   groups in proportion to their size, from a random member
+// - message lengths are log-normal around `length` characters
+//
+// The first five users are the demo accounts, so a generated database can
+// be logged into.
+#ifndef DATAGENERATOR_H
+#define DATAGENERATOR_H
+
+#include <QDateTime>
+
+#include "../setup_db.h"
+
+struct DataGenOptions {
+    quint32 seed;
+    qint64 users;
+    qint64 groups;
+    double zipf;
+    double rate;
+    int days;
+    double direct;
+    double length;
+    double lengthSigma;
+    QDateTime end;
+
+    // quickchat_datagen's defaults: 1000 users, 100 groups, 30 days ending 2024-06-01 UTC
+    static DataGenOptions defaults();
+    // Messages the options produce on average
+    qint64 expectedMessages() const { return qint64(double(users) * rate * days); }
+};
+
+// Writes the rows through a bulk inserter (setup_db.h)
+bool generateChatData(BulkInserter &inserter, const DataGenOptions &options);
+
+#endif // DATAGENERATOR_H
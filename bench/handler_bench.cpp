@@ -0,0 +1,354 @@
+// handler_bench.cpp
+//
+// QBENCHMARK suite for the ChatDatabaseHandler operations the chat views
+// depend on, run against generated databases (datagenerator.h) of about
+// 10k, 1M and 10M messages. Each database is generated once into
+// QUICKCHAT_BENCH_DATA (bench_data/ by default) and copied before every
+// run, so the write benchmarks never change it.
+//
+// Results are written as Qt Test's benchmark CSV and as JSON, both meant
+// to be diffed between commits:
+//
+//     QUICKCHAT_BENCH_SCALES=10k,1m quickchat_handler_bench [Qt Test options]
+//
+//     QUICKCHAT_BENCH_SCALES   scales to run, any of 10k, 1m, 10m (default all)
+//     QUICKCHAT_BENCH_RESULTS  output path without extension (default handler_bench)
+//     QUICKCHAT_BENCH_LABEL    stored in the JSON, e.g. the commit being measured
+#include <QtTest>
+#include <QDir>
+#include <QFile>
+#include <QSqlDatabase>
+#include <QSqlQuery>
+#include <QTemporaryDir>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+
+#include "datagenerator.h"
+#include "../chatdbhandler.h"
+
+namespace {
+
+struct Scale {
+    const char *name;
+    qint64 users;   // ten messages per user per day for ten days
+};
+
+const Scale scales[] = {
+    {"10k", 100},
+    {"1m", 10000},
+    {"10m", 100000},
+};
+
+DataGenOptions scaleOptions(const Scale &scale)
+{
+    DataGenOptions options = DataGenOptions::defaults();
+    options.users = scale.users;
+    options.groups = scale.users / 10;
+    options.rate = 10;
+    options.days = 10;
+    return options;
+}
+
+// An open copy of one generated database and the rows the benchmarks use
+struct Fixture {
+    ChatDatabaseHandler handler;
+    qint64 messages;
+    int groupId;            // largest group
+    QString groupCreator;   // its creator, also a member
+    QString groupMember;    // a member who didn't create it
+    QString directSender;   // busiest direct conversation
+    QString directRecipient;
+    QString deleteGroupId;  // a median sized group
+};
+
+}
+
+class HandlerBench : public QObject
+{
+    Q_OBJECT
+
+public:
+    // Turns Qt Test's CSV into JSON with the dataset sizes
+    bool writeJson(const QString &csvPath, const QString &jsonPath) const;
+
+private slots:
+    void initTestCase();
+    void cleanupTestCase();
+
+    void sendDirectMessage_data() { addScales(); }
+    void sendDirectMessage();
+    void sendGroupMessage_data() { addScales(); }
+    void sendGroupMessage();
+    void getDirectMessageHistory_data() { addScales(); }
+    void getDirectMessageHistory();
+    void getGroupMessageHistory_data() { addScales(); }
+    void getGroupMessageHistory();
+    void getJoinedGroups_data() { addScales(); }
+    void getJoinedGroups();
+    void getCreatedGroups_data() { addScales(); }
+    void getCreatedGroups();
+    void isGroupMember_data() { addScales(); }
+    void isGroupMember();
+    void deleteGroup_data() { addScales(); }
+    void deleteGroup();
+
+private:
+    void addScales();
+    Fixture *fixture();
+    bool openFixture(const Scale &scale, const QString &path);
+
+    QTemporaryDir workDir;
+    QStringList scaleNames;     // in run order
+    QHash<QString, Fixture *> fixtures;
+    QJsonObject datasets;
+};
+
+void HandlerBench::initTestCase()
+{
+    QVERIFY(workDir.isValid());
+
+    QStringList selected = qEnvironmentVariable("QUICKCHAT_BENCH_SCALES", "10k,1m,10m").toLower().split(',', Qt::SkipEmptyParts);
+    QDir dataDir(qEnvironmentVariable("QUICKCHAT_BENCH_DATA", "bench_data"));
+    QVERIFY(dataDir.mkpath("."));
+
+    for (const Scale &scale : scales) {
+        if (!selected.contains(scale.name)) {
+            continue;
+        }
+
+        // Generated once per scale and seed, reused by later runs
+        DataGenOptions options = scaleOptions(scale);
+        QString generated = dataDir.filePath(QString("chat_%1_seed%2.db").arg(scale.name).arg(options.seed));
+        if (!QFile::exists(generated)) {
+            qDebug().noquote() << QString("Generating the %1 database (about %2 messages)")
+                                      .arg(scale.name).arg(options.expectedMessages());
+            int built = bulk_build_chat_db(generated, [&](BulkInserter &inserter) {
+                return generateChatData(inserter, options);
+            });
+            QCOMPARE(built, 0);
+        }
+
+        QString copy = workDir.filePath(QString("%1.db").arg(scale.name));
+        QVERIFY(QFile::copy(generated, copy));
+        QVERIFY(openFixture(scale, copy));
+        scaleNames.append(scale.name);
+    }
+    QVERIFY2(!scaleNames.isEmpty(), "QUICKCHAT_BENCH_SCALES names no known scale");
+}
+
+bool HandlerBench::openFixture(const Scale &scale, const QString &path)
+{
+    Fixture *f = new Fixture;
+    fixtures.insert(scale.name, f);
+
+    // Pick the benchmark's users and groups before the handler opens the file
+    {
+        QSqlDatabase db = QSqlDatabase::addDatabase("QSQLITE", QString("bench_fixture_%1").arg(scale.name));
+        db.setDatabaseName(path);
+        if (!db.open()) {
+            return false;
+        }
+        QSqlQuery query(db);
+        if (!query.exec("SELECT COALESCE(MAX(id), 0) FROM messages") || !query.next()) {
+            return false;
+        }
+        f->messages = query.value(0).toLongLong();
+
+        if (!query.exec("SELECT g.id, u.email FROM chat_groups g JOIN users u ON u.id = g.created_by "
+                        "ORDER BY g.member_count DESC, g.id LIMIT 1") || !query.next()) {
+            return false;
+        }
+        f->groupId = query.value(0).toInt();
+        f->groupCreator = query.value(1).toString();
+
+        // getJoinedGroups leaves out the groups a user created
+        query.prepare("SELECT u.email FROM user_chat_groups ucg JOIN users u ON u.id = ucg.user_id "
+                      "WHERE ucg.chatgroup_id = :group_id AND u.email != :creator LIMIT 1");
+        query.bindValue(":group_id", f->groupId);
+        query.bindValue(":creator", f->groupCreator);
+        if (!query.exec() || !query.next()) {
+            return false;
+        }
+        f->groupMember = query.value(0).toString();
+
+        if (!query.exec("SELECT a.email, b.email FROM conversations c "
+                        "JOIN users a ON a.id = c.user_low JOIN users b ON b.id = c.user_high "
+                        "WHERE c.kind = 'direct' ORDER BY c.message_count DESC, c.id LIMIT 1") || !query.next()) {
+            return false;
+        }
+        f->directSender = query.value(0).toString();
+        f->directRecipient = query.value(1).toString();
+
+        if (!query.exec("SELECT id FROM chat_groups ORDER BY id "
+                        "LIMIT 1 OFFSET (SELECT COUNT(*) FROM chat_groups) / 2") || !query.next()) {
+            return false;
+        }
+        f->deleteGroupId = query.value(0).toString();
+        db.close();
+    }
+    QSqlDatabase::removeDatabase(QString("bench_fixture_%1").arg(scale.name));
+
+    f->handler.setConnectionName(QString("bench_%1").arg(scale.name));
+    f->handler.setDatabaseName(path);
+    if (!f->handler.initialize()) {
+        return false;
+    }
+
+    QJsonObject dataset;
+    dataset["messages"] = f->messages;
+    dataset["users"] = scale.users;
+    dataset["groups"] = scale.users / 10;
+    dataset["seed"] = qint64(scaleOptions(scale).seed);
+    datasets[scale.name] = dataset;
+    return true;
+}
+
+void HandlerBench::cleanupTestCase()
+{
+    qDeleteAll(fixtures);
+    fixtures.clear();
+}
+
+void HandlerBench::addScales()
+{
+    QTest::addColumn<QString>("scale");
+    for (const QString &name : scaleNames) {
+        QTest::newRow(qPrintable(name)) << name;
+    }
+}
+
+Fixture *HandlerBench::fixture()
+{
+    QFETCH(QString, scale);
+    return fixtures.value(scale);
+}
+
+void HandlerBench::sendDirectMessage()
+{
+    Fixture *f = fixture();
+    QBENCHMARK {
+        QVERIFY(f->handler.sendDirectMessage(f->directSender, f->directRecipient, "Benchmark direct message"));
+    }
+}
+
+void HandlerBench::sendGroupMessage()
+{
+    Fixture *f = fixture();
+    QString groupId = QString::number(f->groupId);
+    QBENCHMARK {
+        QVERIFY(f->handler.sendGroupMessage(f->groupCreator, groupId, "Benchmark group message"));
+    }
+}
+
+void HandlerBench::getDirectMessageHistory()
+{
+    Fixture *f = fixture();
+    QVERIFY(!f->handler.getDirectMessageHistory(f->directSender, f->directRecipient, 50).isEmpty());
+    QBENCHMARK {
+        f->handler.getDirectMessageHistory(f->directSender, f->directRecipient, 50);
+    }
+}
+
+void HandlerBench::getGroupMessageHistory()
+{
+    Fixture *f = fixture();
+    QVERIFY(!f->handler.getGroupMessageHistory(f->groupId, 50).isEmpty());
+    QBENCHMARK {
+        f->handler.getGroupMessageHistory(f->groupId, 50);
+    }
+}
+
+void HandlerBench::getJoinedGroups()
+{
+    Fixture *f = fixture();
+    QVERIFY(!f->handler.getJoinedGroups(f->groupMember).isEmpty());
+    QBENCHMARK {
+        f->handler.getJoinedGroups(f->groupMember);
+    }
+}
+
+void HandlerBench::getCreatedGroups()
+{
+    Fixture *f = fixture();
+    QVERIFY(!f->handler.getCreatedGroups(f->groupCreator).isEmpty());
+    QBENCHMARK {
+        f->handler.getCreatedGroups(f->groupCreator);
+    }
+}
+
+void HandlerBench::isGroupMember()
+{
+    Fixture *f = fixture();
+    QBENCHMARK {
+        QVERIFY(f->handler.isGroupMember(f->groupCreator, f->groupId));
+    }
+}
+
+void HandlerBench::deleteGroup()
+{
+    // A group can only be deleted once, so this is a single timed call
+    Fixture *f = fixture();
+    QBENCHMARK_ONCE {
+        QVERIFY(f->handler.deleteGroup(f->deleteGroupId));
+    }
+}
+
+bool HandlerBench::writeJson(const QString &csvPath, const QString &jsonPath) const
+{
+    QFile csv(csvPath);
+    if (!csv.open(QIODevice::ReadOnly | QIODevice::Text)) {
+        return false;
+    }
+
+    // "function","scale","metric",value per iteration,total,iterations
+    QJsonArray results;
+    while (!csv.atEnd()) {
+        const QStringList fields = QString::fromUtf8(csv.readLine()).trimmed().split(',');
+        if (fields.size() < 5) {
+            continue;
+        }
+        QJsonObject result;
+        result["function"] = QString(fields[0]).remove('"');
+        result["scale"] = QString(fields[1]).remove('"');
+        result["metric"] = QString(fields[2]).remove('"');
+        result["value"] = fields[3].toDouble();
+        result["iterations"] = fields.last().toLongLong();
+        results.append(result);
+    }
+
+    QJsonObject root;
+    root["suite"] = "quickchat_handler_bench";
+    root["label"] = qEnvironmentVariable("QUICKCHAT_BENCH_LABEL");
+    root["time"] = QDateTime::currentDateTimeUtc().toString(Qt::ISODate);
+    root["qt"] = QString(qVersion());
+    root["datasets"] = datasets;
+    root["results"] = results;
+
+    QFile json(jsonPath);
+    if (!json.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        qDebug() << "Failed to write" << jsonPath;
+        return false;
+    }
+    json.write(QJsonDocument(root).toJson());
+    return true;
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+
+    // Console output as usual, plus the CSV the JSON is made from
+    QString results = qEnvironmentVariable("QUICKCHAT_BENCH_RESULTS", "handler_bench");
+    QStringList args = app.arguments();
+    args << "-o" << "-,txt" << "-o" << results + ".csv,csv";
+
+    HandlerBench bench;
+    int failed = QTest::qExec(&bench, args);
+    if (bench.writeJson(results + ".csv", results + ".json")) {
+        qDebug().noquote() << "Results written to" << results + ".csv" << "and" << results + ".json";
+    }
+    return failed;
+}
+
+#include "handler_bench.moc"
@@ -0,0 +1,220 @@
+// message_batch_bench.cpp
+//
+// Heap allocations and time for reading one page of group messages as
+// per-row tuples, the way history was loaded before MessageBatch, versus a
+// MessageBatch (getGroupMessageBatch).
+//
+//     quickchat_message_batch_bench [rows]    (default 10000)
+//
+// Allocations are counted by wrapping malloc, so QString and QList buffers
+// are included. That needs glibc; elsewhere the counts read 0.
+#include <QCoreApplication>
+#include <QSqlDatabase>
+#include <QSqlQuery>
+#include <QSqlError>
+#include <QTemporaryDir>
+#include <QElapsedTimer>
+#include <QDir>
+#include <QDebug>
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <tuple>
+
+#include "../setup_db.h"
+#include "../chatdbhandler.h"
+
+namespace {
+
+std::atomic<bool> counting{false};
+std::atomic<quint64> allocations{0};
+
+}
+
+#if defined(__GLIBC__)
+extern "C" {
+void *__libc_malloc(size_t size);
+void *__libc_calloc(size_t count, size_t size);
+void *__libc_realloc(void *ptr, size_t size);
+
+void *malloc(size_t size)
+{
+    if (counting.load(std::memory_order_relaxed)) {
+        allocations.fetch_add(1, std::memory_order_relaxed);
+    }
+    return __libc_malloc(size);
+}
+
+void *calloc(size_t count, size_t size)
+{
+    if (counting.load(std::memory_order_relaxed)) {
+        allocations.fetch_add(1, std::memory_order_relaxed);
+    }
+    return __libc_calloc(count, size);
+}
+
+void *realloc(void *ptr, size_t size)
+{
+    if (counting.load(std::memory_order_relaxed)) {
+        allocations.fetch_add(1, std::memory_order_relaxed);
+    }
+    return __libc_realloc(ptr, size);
+}
+}
+#endif
+
+namespace {
+
+// Adds rows messages from the five demo users to the General group (id 1)
+bool fill(int rows)
+{
+    QSqlDatabase db = QSqlDatabase::addDatabase("QSQLITE", "bench_fill");
+    db.setDatabaseName("chat_database.db");
+    if (!db.open()) {
+        qDebug() << "Failed to open benchmark database:" << db.lastError().text();
+        return false;
+    }
+
+    bool ok = true;
+    {
+        db.transaction();
+        QSqlQuery insert(db);
+        insert.prepare("INSERT INTO messages (sender_id, chatgroup_id, content, timestamp, type) "
+                       "VALUES (:sender, 1, :content, :timestamp, :type)");
+
+        qint64 time = currentStoredTimestamp() - qint64(rows) * 2000;
+        for (int i = 0; i < rows && ok; ++i) {
+            insert.bindValue(":sender", 1 + i % 5);
+            insert.bindValue(":content", QString("benchmark message %1").arg(i));
+            insert.bindValue(":timestamp", time + qint64(i) * 2000);
+            insert.bindValue(":type", i % 50 == 0 ? "system" : "user");
+            if (!insert.exec()) {
+                qDebug() << "Insert failed:" << insert.lastError().text();
+                ok = false;
+            }
+        }
+        if (ok) {
+            ok = db.commit();
+        } else {
+            db.rollback();
+        }
+    }
+
+    db.close();
+    db = QSqlDatabase();
+    QSqlDatabase::removeDatabase("bench_fill");
+    return ok;
+}
+
+// (message_id, sender_name, sender_email, content, timestamp, type)
+using MessageRow = std::tuple<qint64, QString, QString, QString, QDateTime, QString>;
+
+// The newest page of the General group with the sender joined into every row
+QList<MessageRow> readRowPage(QSqlQuery &query, int rows)
+{
+    QList<MessageRow> page;
+    query.bindValue(":limit", rows);
+    if (!query.exec()) {
+        qDebug() << "Query failed:" << query.lastError().text();
+        return page;
+    }
+    while (query.next()) {
+        page.append(std::make_tuple(query.value(0).toLongLong(), query.value(1).toString(),
+                                    query.value(2).toString(), query.value(3).toString(),
+                                    fromStoredTimestamp(query.value(4)), query.value(5).toString()));
+    }
+    std::reverse(page.begin(), page.end());
+    return page;
+}
+
+struct Sample {
+    qint64 elapsedUs;
+    quint64 allocations;
+    qint64 checksum;
+};
+
+// Runs read once while counting allocations
+template <typename Read>
+Sample measure(Read read)
+{
+    QElapsedTimer timer;
+    allocations = 0;
+    counting = true;
+    timer.start();
+    qint64 checksum = read();
+    qint64 elapsed = timer.nsecsElapsed() / 1000;
+    counting = false;
+    return Sample{elapsed, allocations.load(), checksum};
+}
+
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+
+    int rows = argc > 1 ? QString(argv[1]).toInt() : 10000;
+
+    // setup_chat_db and the handler both use chat_database.db in the working directory
+    QTemporaryDir dir;
+    QDir::setCurrent(dir.path());
+    if (setup_chat_db() != 0 || !fill(rows)) {
+        return 1;
+    }
+
+    ChatDatabaseHandler handler;
+    handler.setConnectionName("bench");
+    if (!handler.initialize()) {
+        return 1;
+    }
+
+    // The tuple baseline reads the same file through its own connection
+    QSqlDatabase rowsDb = QSqlDatabase::addDatabase("QSQLITE", "bench_rows");
+    rowsDb.setDatabaseName("chat_database.db");
+    if (!rowsDb.open()) {
+        qDebug() << "Failed to open benchmark database:" << rowsDb.lastError().text();
+        return 1;
+    }
+    QSqlQuery rowQuery(rowsDb);
+    rowQuery.prepare("SELECT m.id, u.name, u.email, m.content, m.timestamp, m.type FROM messages m "
+                     "JOIN users u ON m.sender_id = u.id WHERE m.chatgroup_id = 1 "
+                     "ORDER BY m.id DESC LIMIT :limit");
+
+    auto readRows = [&]() {
+        const QList<MessageRow> page = readRowPage(rowQuery, rows);
+        qint64 sum = 0;
+        for (const auto &row : page) {
+            sum += std::get<0>(row) + std::get<2>(row).size();
+        }
+        return sum;
+    };
+    auto readBatch = [&]() {
+        const MessageBatch batch =
+            handler.getGroupMessageBatch(1, 0, ChatDatabaseHandler::PageDirection::Before, rows);
+        qint64 sum = 0;
+        for (const Message &message : batch.messages) {
+            sum += message.id + batch.sender(message).email.size();
+        }
+        return sum;
+    };
+
+    // Prepare both statements and warm the page cache
+    readRows();
+    readBatch();
+
+    Sample tuples = measure(readRows);
+    Sample batch = measure(readBatch);
+
+    qDebug().noquote() << QString("page of %1 rows").arg(rows);
+    qDebug().noquote() << QString("MessageRow tuples: %1 us, %2 allocations (%3 per row, checksum %4)")
+                              .arg(tuples.elapsedUs).arg(tuples.allocations)
+                              .arg(double(tuples.allocations) / rows, 0, 'f', 1).arg(tuples.checksum);
+    qDebug().noquote() << QString("MessageBatch:      %1 us, %2 allocations (%3 per row, checksum %4)")
+                              .arg(batch.elapsedUs).arg(batch.allocations)
+                              .arg(double(batch.allocations) / rows, 0, 'f', 1).arg(batch.checksum);
+    if (batch.allocations > 0) {
+        qDebug().noquote() << QString("allocation reduction: %1x")
+                                  .arg(double(tuples.allocations) / batch.allocations, 0, 'f', 2);
+    }
+    return 0;
+}
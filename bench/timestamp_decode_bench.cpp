@@ -0,0 +1,122 @@
+// timestamp_decode_bench.cpp
+//
+// Row-decode cost of message timestamps stored as formatted text (the
+// pre-migration format) versus INTEGER epoch milliseconds.
+//
+//     quickchat_timestamp_bench [rows]    (default 1000000)
+#include <QCoreApplication>
+#include <QSqlDatabase>
+#include <QSqlQuery>
+#include <QSqlError>
+#include <QTemporaryDir>
+#include <QElapsedTimer>
+#include <QDateTime>
+#include <QDebug>
+
+#include "../messagetime.h"
+
+namespace {
+
+bool fill(QSqlDatabase &db, int rows)
+{
+    QSqlQuery query(db);
+    if (!query.exec("CREATE TABLE text_messages (id INTEGER PRIMARY KEY, content TEXT, timestamp DATETIME)")
+        || !query.exec("CREATE TABLE epoch_messages (id INTEGER PRIMARY KEY, content TEXT, timestamp INTEGER)")) {
+        qDebug() << "Failed to create tables:" << query.lastError().text();
+        return false;
+    }
+
+    db.transaction();
+    QSqlQuery insertText(db);
+    QSqlQuery insertEpoch(db);
+    insertText.prepare("INSERT INTO text_messages (content, timestamp) VALUES (:content, :timestamp)");
+    insertEpoch.prepare("INSERT INTO epoch_messages (content, timestamp) VALUES (:content, :timestamp)");
+
+    QDateTime time = QDateTime::currentDateTime().addDays(-365);
+    for (int i = 0; i < rows; ++i) {
+        time = time.addMSecs(1500 + (i % 7) * 400);
+        QString content = QString("benchmark message %1").arg(i);
+
+        insertText.bindValue(":content", content);
+        insertText.bindValue(":timestamp", time.toString("yyyy-MM-dd hh:mm:ss"));
+        insertEpoch.bindValue(":content", content);
+        insertEpoch.bindValue(":timestamp", toStoredTimestamp(time));
+        if (!insertText.exec() || !insertEpoch.exec()) {
+            qDebug() << "Insert failed:" << insertText.lastError().text() << insertEpoch.lastError().text();
+            db.rollback();
+            return false;
+        }
+    }
+    return db.commit();
+}
+
+// Runs the query and decodes each timestamp with decode; returns elapsed ms
+template <typename Decode>
+qint64 timeScan(QSqlDatabase &db, const QString &table, Decode decode, qint64 *checksum)
+{
+    QSqlQuery query(db);
+    query.setForwardOnly(true);
+
+    QElapsedTimer timer;
+    timer.start();
+    query.exec(QString("SELECT id, content, timestamp FROM %1 ORDER BY timestamp").arg(table));
+    qint64 sum = 0;
+    while (query.next()) {
+        sum += decode(query.value(2)).toMSecsSinceEpoch() % 1000;
+    }
+    qint64 elapsed = timer.elapsed();
+
+    *checksum = sum;
+    return elapsed;
+}
+
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+
+    int rows = argc > 1 ? QString(argv[1]).toInt() : 1000000;
+
+    QTemporaryDir dir;
+    QSqlDatabase db = QSqlDatabase::addDatabase("QSQLITE", "bench");
+    db.setDatabaseName(dir.filePath("timestamps.db"));
+    if (!db.open()) {
+        qDebug() << "Failed to open benchmark database:" << db.lastError().text();
+        return 1;
+    }
+
+    qDebug() << "Filling" << rows << "rows per table...";
+    if (!fill(db, rows)) {
+        return 1;
+    }
+
+    qint64 checksum = 0;
+
+    // Warm the page cache so both scans read from memory
+    timeScan(db, "text_messages", [](const QVariant &v) { return QDateTime::fromMSecsSinceEpoch(v.toLongLong()); }, &checksum);
+    timeScan(db, "epoch_messages", [](const QVariant &v) { return QDateTime::fromMSecsSinceEpoch(v.toLongLong()); }, &checksum);
+
+    qint64 textMs = timeScan(db, "text_messages", [](const QVariant &v) {
+        return QDateTime::fromString(v.toString(), "yyyy-MM-dd hh:mm:ss");
+    }, &checksum);
+    qint64 textSum = checksum;
+
+    qint64 epochMs = timeScan(db, "epoch_messages", [](const QVariant &v) {
+        return fromStoredTimestamp(v);
+    }, &checksum);
+    qint64 epochSum = checksum;
+
+    qDebug().noquote() << QString("text timestamps:  %1 ms (%2 ns/row, checksum %3)")
+                              .arg(textMs).arg(textMs * 1000000.0 / rows, 0, 'f', 1).arg(textSum);
+    qDebug().noquote() << QString("epoch timestamps: %1 ms (%2 ns/row, checksum %3)")
+                              .arg(epochMs).arg(epochMs * 1000000.0 / rows, 0, 'f', 1).arg(epochSum);
+    if (epochMs > 0) {
+        qDebug().noquote() << QString("speedup: %1x").arg(double(textMs) / epochMs, 0, 'f', 2);
+    }
+
+    db.close();
+    db = QSqlDatabase();
+    QSqlDatabase::removeDatabase("bench");
+    return 0;
+}
@@ -1,736 +1,2257 @@
-// chatdbhandler.cpp
-#include "chatdbhandler.h"
-
-ChatDatabaseHandler::ChatDatabaseHandler(QObject *parent)
-    : QObject(parent), dbInitialized(false)
-{
-}
-
-ChatDatabaseHandler::~ChatDatabaseHandler()
-{
-    if (db.isOpen()) {
-        db.close();
-    }
-}
-
-bool ChatDatabaseHandler::initialize()
-{
-    // Check if db is already initialized
-    if (dbInitialized) {
-        return true;
-    }
-
-    // Setup connection
-    db = QSqlDatabase::addDatabase("QSQLITE");
-    db.setDatabaseName("chat_database.db");
-
-    if (!db.open()) {
-        qDebug() << "Failed to open database:" << db.lastError().text();
-        return false;
-    }
-
-    dbInitialized = true;
-    return true;
-}
-
-bool ChatDatabaseHandler::executeQuery(const QString &sql)
-{
-    if (!dbInitialized) {
-        qDebug() << "Database not initialized";
-        return false;
-    }
-
-    QSqlQuery query(db);
-    if (!query.exec(sql)) {
-        qDebug() << "Query failed:" << query.lastError().text();
-        qDebug() << "SQL:" << sql;
-        return false;
-    }
-    return true;
-}
-
-bool ChatDatabaseHandler::checkTableExists(const QString &tableName)
-{
-    if (!dbInitialized) {
-        return false;
-    }
-
-    QSqlQuery query(db);
-    query.prepare("SELECT name FROM sqlite_master WHERE type='table' AND name=:name");
-    query.bindValue(":name", tableName);
-
-    if (query.exec() && query.next()) {
-        return true;
-    }
-    return false;
-}
-
-QString ChatDatabaseHandler::loginUser(const QString &email, const QString &password)
-{
-    if (!dbInitialized) {
-        qDebug() << "Database not initialized";
-        return QString(); // Return empty string on failure
-    }
-
-    QSqlQuery query(db);
-    query.prepare("SELECT name FROM users WHERE email = :email AND password = :password");
-    query.bindValue(":email", email);
-    query.bindValue(":password", password); // In real app, use hashed passwords
-
-    if (query.exec() && query.next()) {
-        QString userName = query.value(0).toString();
-        qDebug() << "Login successful for user:" << userName;
-        return userName;
-    }
-
-    qDebug() << "Login failed for email:" << email;
-    return QString(); // Return empty string if login fails
-}
-
-bool ChatDatabaseHandler::registerUser(const QString &username, const QString &email, const QString &password)
-{
-    if (!dbInitialized) {
-        return false;
-    }
-    // Check if username already exists
-    QSqlQuery checkQuery(db);
-    checkQuery.prepare("SELECT id FROM users WHERE name = :username OR email = :email");
-    checkQuery.bindValue(":username", username);
-    checkQuery.bindValue(":email", email);
-    if (checkQuery.exec() && checkQuery.next()) {
-        return false; // Username or email already exists
-    }
-    // Create new user
-    QSqlQuery insertQuery(db);
-    insertQuery.prepare("INSERT INTO users (name, email, password) VALUES (:username, :email, :password)");
-    insertQuery.bindValue(":username", username);
-    insertQuery.bindValue(":email", email);
-    insertQuery.bindValue(":password", password); // In real app, hash passwords
-    return insertQuery.exec();
-}
-
-QString ChatDatabaseHandler::userExists(const QString & email) {
-    if (!dbInitialized) {
-        return QString();
-    }
-
-    QSqlQuery query(db);
-    query.prepare("SELECT name FROM users WHERE email = :email");
-    query.bindValue(":email", email);
-
-
-    if (query.exec() && query.next()) {
-        return query.value(0).toString(); // User exists with matching password
-    }
-    return QString();
-
-}
-
-QString ChatDatabaseHandler::groupChatExists(const QString & chatId) {
-    if (!dbInitialized) {
-        return QString();
-    }
-
-
-    QSqlQuery query(db);
-    query.prepare("SELECT name FROM chat_groups WHERE id = :chatId");
-    query.bindValue(":chatId", chatId);
-
-
-    if (query.exec() && query.next()) {
-
-        return query.value(0).toString(); // Group exists
-    }
-    return QString();
-
-}
-
-
-
-
-int ChatDatabaseHandler::createGroupChat(const QString &name, const QString &creatorEmail)
-{
-    if (!dbInitialized) {
-        return -1; // Return -1 to indicate failure
-    }
-
-
-    // First, find the user ID for the given email
-    QSqlQuery userQuery(db);
-    userQuery.prepare("SELECT id FROM users WHERE email = :creatorEmail");
-
-    userQuery.bindValue(":creatorEmail", creatorEmail);
-
-
-    if (!userQuery.exec() || !userQuery.next()) {
-
-        return -1; // No user found with this email
-    }
-
-    int creatorId = userQuery.value(0).toInt();
-
-
-    // Check if group already exists
-    // QSqlQuery checkQuery(db);
-    // checkQuery.prepare("SELECT id FROM chat_groups WHERE name = :name");
-    // checkQuery.bindValue(":name", name);
-    // if (checkQuery.exec() && checkQuery.next()) {
-    //     return checkQuery.value(0).toInt(); // Return existing group ID
-    // }
-
-    // Create new group
-    QSqlQuery insertQuery(db);
-    insertQuery.prepare("INSERT INTO chat_groups (name, created_at, created_by) VALUES (:name, :created_at, :created_by)");
-    insertQuery.bindValue(":name", name);
-    insertQuery.bindValue(":created_at", QDateTime::currentDateTime().toString("yyyy-MM-dd hh:mm:ss"));
-    insertQuery.bindValue(":created_by", creatorId);
-
-    if (!insertQuery.exec()) {
-        return -1; // Return -1 if insertion fails
-    }
-
-    // Get the ID of the newly created group
-    int newGroupId = insertQuery.lastInsertId().toInt();
-
-    // Automatically add the creator to the group
-    QSqlQuery addCreatorQuery(db);
-    addCreatorQuery.prepare("INSERT INTO user_chat_groups (user_id, chatgroup_id) VALUES (:user_id, :chatgroup_id)");
-    addCreatorQuery.bindValue(":user_id", creatorId);
-    addCreatorQuery.bindValue(":chatgroup_id", newGroupId);
-
-    if (!addCreatorQuery.exec()) {
-        // Optionally, you might want to delete the group if adding the creator fails
-        return -1;
-    }
-
-    return newGroupId;
-}
-
-
-bool ChatDatabaseHandler::joinGroupChat(const QString &userEmail, const QString &groupId)
-{
-    if (!dbInitialized) {
-        return false;
-    }
-
-    // Get user ID
-    QSqlQuery userQuery(db);
-    userQuery.prepare("SELECT id FROM users WHERE email = :email");
-    userQuery.bindValue(":email", userEmail);
-
-    if (!userQuery.exec() || !userQuery.next()) {
-        return false; // User not found
-    }
-
-    int userId = userQuery.value(0).toInt();
-
-    // Check if user is already in the group
-    QSqlQuery checkQuery(db);
-    checkQuery.prepare("SELECT user_id FROM user_chat_groups WHERE user_id = :user_id AND chatgroup_id = :group_id");
-    checkQuery.bindValue(":user_id", userId);
-    checkQuery.bindValue(":group_id", groupId);
-
-    if (checkQuery.exec() && checkQuery.next()) {
-        return true; // User is already in the group
-    }
-
-    // Add user to group
-    QSqlQuery joinQuery(db);
-    joinQuery.prepare("INSERT INTO user_chat_groups (user_id, chatgroup_id) VALUES (:user_id, :group_id)");
-    joinQuery.bindValue(":user_id", userId);
-    joinQuery.bindValue(":group_id", groupId);
-
-    return joinQuery.exec();
-}
-
-QStringList ChatDatabaseHandler::getUserGroups(const QString &userEmail) const
-{
-    QStringList groups;
-
-    if (!dbInitialized) {
-        return groups;
-    }
-
-    QSqlQuery query(db);
-    query.prepare("SELECT g.name FROM chat_groups g "
-                  "JOIN user_chat_groups ug ON g.id = ug.chatgroup_id "
-                  "JOIN users u ON u.id = ug.user_id "
-                  "WHERE u.email = :userEmail "
-                  "ORDER BY g.name");
-    query.bindValue(":userEmail", userEmail);
-
-    if (query.exec()) {
-        while (query.next()) {
-            groups << query.value(0).toString();
-        }
-    }
-
-    return groups;
-}
-
-QList<QPair<QString, QString>> ChatDatabaseHandler::getGroupChatMembers(const QString &chatName) {
-    QList<QPair<QString, QString>> members;
-    if (!dbInitialized) {
-        return members;
-    }
-
-    QSqlQuery query(db);
-    query.prepare("SELECT u.name, u.email FROM users u "
-                  "JOIN user_chat_groups ug ON u.id = ug.user_id "
-                  "JOIN chat_groups cg ON ug.chatgroup_id = cg.id "
-                  "WHERE cg.name = :chatName "
-                  "ORDER BY u.name");
-    query.bindValue(":chatName", chatName);
-
-    if (query.exec()) {
-        while (query.next()) {
-            QString name = query.value(0).toString();
-            QString email = query.value(1).toString();
-            members.append(QPair<QString, QString>(name, email));
-        }
-    } else {
-        qDebug() << "Error fetching group members:" << query.lastError().text();
-    }
-
-    return members;
-}
-
-bool ChatDatabaseHandler::sendDirectMessage(const QString &sender, const QString &recipient, const QString &content)
-{
-    if (!dbInitialized || content.isEmpty()) {
-        return false;
-    }
-
-    // Get sender ID
-    QSqlQuery senderQuery(db);
-    senderQuery.prepare("SELECT id FROM users WHERE email = :email");
-    senderQuery.bindValue(":email", sender);
-
-    if (!senderQuery.exec() || !senderQuery.next()) {
-        qDebug() << "Sender not found:" << sender;
-        return false; // Sender not found
-    }
-
-    int senderId = senderQuery.value(0).toInt();
-
-    // Get recipient ID
-    QSqlQuery recipientQuery(db);
-    recipientQuery.prepare("SELECT id FROM users WHERE email = :email");
-    recipientQuery.bindValue(":email", recipient);
-
-    if (!recipientQuery.exec() || !recipientQuery.next()) {
-        qDebug() << "Recipient not found:" << recipient;
-        return false; // Recipient not found
-    }
-
-    int recipientId = recipientQuery.value(0).toInt();
-
-    // Send message
-    QSqlQuery messageQuery(db);
-    messageQuery.prepare("INSERT INTO messages (sender_id, chatgroup_id, recipient_id, content, timestamp) "
-                         "VALUES (:sender_id, NULL, :recipient_id, :content, :timestamp)");
-    messageQuery.bindValue(":sender_id", senderId);
-    messageQuery.bindValue(":recipient_id", recipientId);
-    messageQuery.bindValue(":content", content);
-    messageQuery.bindValue(":timestamp", QDateTime::currentDateTime().toString("yyyy-MM-dd hh:mm:ss"));
-
-    if (!messageQuery.exec()) {
-        qDebug() << "Failed to insert message:" << messageQuery.lastError().text();
-        return false;
-    }
-
-    return true;
-}
-
-bool ChatDatabaseHandler::sendGroupMessage(const QString &sender, const QString &groupId,
-                                           const QString &content, const QString &type)
-{
-
-    if (!dbInitialized || content.isEmpty()) {
-        return false;
-    }
-
-    // Get sender ID
-    QSqlQuery senderQuery(db);
-    senderQuery.prepare("SELECT id FROM users WHERE email = :email");
-    senderQuery.bindValue(":email", sender);
-    if (!senderQuery.exec() || !senderQuery.next()) {
-        qDebug() << sender;
-
-        return false; // Sender not found
-    }
-    int senderId = senderQuery.value(0).toInt();
-
-    // Get group ID - now using id directly if it's a number, otherwise query by name
-    int groupIdInt;
-    bool isNumber;
-    groupIdInt = groupId.toInt(&isNumber);
-    
-    if (!isNumber) {
-        QSqlQuery groupQuery(db);
-        groupQuery.prepare("SELECT id FROM chat_groups WHERE name = :name");
-        groupQuery.bindValue(":name", groupId);
-        if (!groupQuery.exec() || !groupQuery.next()) {
-            qDebug() << "group not found:" << groupId;
-            return false; // Group not found
-        }
-        groupIdInt = groupQuery.value(0).toInt();
-    }
-
-    // Send message
-    QSqlQuery messageQuery(db);
-    messageQuery.prepare("INSERT INTO messages (sender_id, chatgroup_id, recipient_id, content, timestamp, type) "
-                         "VALUES (:sender_id, :group_id, NULL, :content, :timestamp, :type)");
-    messageQuery.bindValue(":sender_id", senderId);
-    messageQuery.bindValue(":group_id", groupIdInt);
-    messageQuery.bindValue(":content", content);
-    messageQuery.bindValue(":timestamp", QDateTime::currentDateTime().toString("yyyy-MM-dd hh:mm:ss"));
-    messageQuery.bindValue(":type", type);
-    
-    if (!messageQuery.exec()) {
-        qDebug() << "Failed to send message:" << messageQuery.lastError().text();
-        return false;
-    }
-    return true;
-}
-
-// Using std::tuple
-QList<std::tuple<QString, QString, QString, QDateTime>> ChatDatabaseHandler::getDirectMessageHistory(const QString &user1, const QString &user2, int limit)
-{
-    QList<std::tuple<QString, QString, QString, QDateTime>> messages;
-    if (!dbInitialized) {
-        return messages;
-    }
-
-    QSqlQuery query(db);
-    query.prepare("SELECT u.name, u.email, m.content, m.timestamp FROM messages m "
-                  "JOIN users u ON m.sender_id = u.id "
-                  "WHERE (m.sender_id = (SELECT id FROM users WHERE email = :user1) AND "
-                  "       m.recipient_id = (SELECT id FROM users WHERE email = :user2)) OR "
-                  "      (m.sender_id = (SELECT id FROM users WHERE email = :user2) AND "
-                  "       m.recipient_id = (SELECT id FROM users WHERE email = :user1)) "
-                  "ORDER BY m.timestamp DESC LIMIT :limit");
-    query.bindValue(":user1", user1);
-    query.bindValue(":user2", user2);
-    query.bindValue(":limit", limit);
-
-    if (query.exec()) {
-        while (query.next()) {
-            QString senderName = query.value(0).toString();
-            QString senderEmail = query.value(1).toString();
-            QString content = query.value(2).toString();
-            QDateTime timestamp = query.value(3).toDateTime();
-
-            messages.append(std::make_tuple(senderName, senderEmail, content, timestamp));
-        }
-        // Reverse to get chronological order
-        std::reverse(messages.begin(), messages.end());
-    } else {
-        qDebug() << "Query failed:" << query.lastError().text();
-        qDebug() << "Query string:" << query.lastQuery(); // Debug line
-    }
-
-    return messages;
-}
-
-
-QList<std::tuple<QString, QString, QString, QDateTime, QString>> ChatDatabaseHandler::getGroupMessageHistory(const QString &groupName, int limit)
-{
-    QList<std::tuple<QString, QString, QString, QDateTime, QString>> messages;
-
-    QSqlQuery query(db);
-    query.prepare("SELECT u.name, u.email, m.content, m.timestamp, m.type FROM messages m "
-                  "JOIN users u ON m.sender_id = u.id "
-                  "JOIN chat_groups g ON m.chatgroup_id = g.id "
-                  "WHERE g.name = :groupName "
-                  "ORDER BY m.timestamp ASC LIMIT :limit");
-
-    query.bindValue(":groupName", groupName);
-    query.bindValue(":limit", limit);
-
-    if (query.exec()) {
-        while (query.next()) {
-            QString sender = query.value(0).toString();
-            QString senderEmail = query.value(1).toString();
-            QString content = query.value(2).toString();
-            QDateTime timestamp = QDateTime::fromString(query.value(3).toString(), "yyyy-MM-dd hh:mm:ss");
-            QString type = query.value(4).toString();  // Get the type
-
-            messages.append(std::make_tuple(sender, senderEmail, content, timestamp, type));
-        }
-    }
-
-
-    return messages;
-}
-
-bool ChatDatabaseHandler::isGroupMember(const QString &email, const QString &groupName)
-{
-    if (!dbInitialized) {
-        return false;
-    }
-
-
-    QSqlQuery query(db);
-    query.prepare("SELECT user_id FROM user_chat_groups ucg "
-                  "JOIN users u ON ucg.user_id = u.id "
-                  "JOIN chat_groups g ON ucg.chatgroup_id = g.id "
-                  "WHERE u.email = :email AND g.name = :groupName");
-
-    query.bindValue(":email", email);
-    query.bindValue(":groupName", groupName);
-
-    if (query.exec() && query.next()) {
-        // If a record is found, the user is a member of the group
-        // qDebug() << email << "is already a group member";
-        return true;
-    }
-
-    // qDebug() << email << "is not a group member";
-
-    return false;
-}
-
-bool ChatDatabaseHandler::removeUserFromGroup(const QString &email, const QString &groupName)
-{
-    if (!dbInitialized) {
-        return false;
-    }
-
-
-
-    // First, get the user and group IDs
-    int userId = -1;
-    int groupId = -1;
-
-    QSqlQuery userQuery(db);
-    userQuery.prepare("SELECT id FROM users WHERE email = :email");
-    userQuery.bindValue(":email", email);
-
-    if (userQuery.exec() && userQuery.next()) {
-        userId = userQuery.value(0).toInt();
-
-    } else {
-        return false; // User not found
-    }
-
-    QSqlQuery groupQuery(db);
-    groupQuery.prepare("SELECT id FROM chat_groups WHERE name = :name");
-    groupQuery.bindValue(":name", groupName);
-
-    if (groupQuery.exec() && groupQuery.next()) {
-        groupId = groupQuery.value(0).toInt();
-
-    } else {
-        return false; // Group not found
-    }
-
-    // Now remove the user from the group
-    QSqlQuery removeQuery(db);
-    removeQuery.prepare("DELETE FROM user_chat_groups WHERE user_id = :userId AND chatgroup_id = :groupId");
-    removeQuery.bindValue(":userId", userId);
-    removeQuery.bindValue(":groupId", groupId);
-
-    return removeQuery.exec();
-}
-
-QList<std::tuple<QString, QString, int>> ChatDatabaseHandler::getGroupDetails(const QString &userEmail) const
-{
-    QList<std::tuple<QString, QString, int>> groups;
-
-    if (!dbInitialized) {
-        return groups;
-    }
-
-    QSqlQuery query(db);
-    query.prepare(
-        "SELECT g.id, g.name, COUNT(DISTINCT ug2.user_id) as member_count "
-        "FROM chat_groups g "
-        "JOIN user_chat_groups ug ON g.id = ug.chatgroup_id "
-        "JOIN users u ON u.id = ug.user_id "
-        "JOIN user_chat_groups ug2 ON g.id = ug2.chatgroup_id "
-        "WHERE u.email = :userEmail "
-        "GROUP BY g.id, g.name "
-        "ORDER BY g.name"
-    );
-    query.bindValue(":userEmail", userEmail);
-
-    if (query.exec()) {
-        while (query.next()) {
-            groups.append(std::make_tuple(
-                query.value(0).toString(),  // group id
-                query.value(1).toString(),  // group name
-                query.value(2).toInt()      // member count
-            ));
-        }
-    }
-
-    return groups;
-}
-
-QList<std::tuple<QString, QString, int>> ChatDatabaseHandler::getCreatedGroups(const QString &userEmail) const
-{
-    QList<std::tuple<QString, QString, int>> groups;
-    if (!dbInitialized) {
-        return groups;
-    }
-
-    QSqlQuery query(db);
-    query.prepare(
-        "SELECT cg.id, cg.name, COUNT(DISTINCT ucg.user_id) as member_count "
-        "FROM chat_groups cg "
-        "LEFT JOIN user_chat_groups ucg ON cg.id = ucg.chatgroup_id "
-        "WHERE cg.created_by = (SELECT id FROM users WHERE email = :email) "
-        "GROUP BY cg.id, cg.name "
-        "ORDER BY cg.name"
-    );
-    query.bindValue(":email", userEmail);
-
-    if (query.exec()) {
-        while (query.next()) {
-            groups.append(std::make_tuple(
-                query.value(0).toString(),
-                query.value(1).toString(),
-                query.value(2).toInt()
-            ));
-        }
-        // qDebug() << "Created groups for" << userEmail << ":" << groups.size() << "groups found";
-    } else {
-        qDebug() << "Error in getCreatedGroups:" << query.lastError().text();
-        qDebug() << "Query:" << query.lastQuery();
-    }
-
-    return groups;
-}
-
-QList<std::tuple<QString, QString, int>> ChatDatabaseHandler::getJoinedGroups(const QString &userEmail) const
-{
-    QList<std::tuple<QString, QString, int>> groups;
-    if (!dbInitialized) {
-        return groups;
-    }
-
-    // Get user ID first
-    QSqlQuery userQuery(db);
-    userQuery.prepare("SELECT id FROM users WHERE email = :email");
-    userQuery.bindValue(":email", userEmail);
-    
-    if (!userQuery.exec() || !userQuery.next()) {
-        qDebug() << "Error getting user ID for" << userEmail;
-        return groups;
-    }
-    
-    int userId = userQuery.value(0).toInt();
-
-    QSqlQuery query(db);
-    query.prepare(
-        "SELECT cg.id, cg.name, COUNT(DISTINCT ucg2.user_id) as member_count "
-        "FROM chat_groups cg "
-        "INNER JOIN user_chat_groups ucg1 ON cg.id = ucg1.chatgroup_id AND ucg1.user_id = :user_id "
-        "LEFT JOIN user_chat_groups ucg2 ON cg.id = ucg2.chatgroup_id "
-        "WHERE cg.created_by != :user_id "
-        "GROUP BY cg.id, cg.name "
-        "ORDER BY cg.name"
-    );
-    query.bindValue(":user_id", userId);
-
-    if (query.exec()) {
-        while (query.next()) {
-            groups.append(std::make_tuple(
-                query.value(0).toString(),
-                query.value(1).toString(),
-                query.value(2).toInt()
-            ));
-        }
-        qDebug() << "Joined groups for" << userEmail << ":" << groups.size() << "groups found";
-    } else {
-        qDebug() << "Error in getJoinedGroups:" << query.lastError().text();
-        qDebug() << "Query:" << query.lastQuery();
-    }
-
-    return groups;
-}
-
-QPair<QString, QString> ChatDatabaseHandler::getGroupAdmin(const QString &groupId) {
-    QString name;
-    QString email;
-
-    if (!dbInitialized) {
-        return QPair<QString, QString>(name, email);
-    }
-
-    QSqlQuery query(db);
-    query.prepare(
-        "SELECT u.name, u.email FROM users u "
-        "JOIN chat_groups cg ON u.id = cg.created_by "
-        "WHERE cg.id = :groupId"
-        );
-    query.bindValue(":groupId", groupId);
-
-    if (query.exec()) {
-        if (query.next()) {  // Move to the first (and only) result row
-            name = query.value(0).toString();
-            email = query.value(1).toString();
-        } else {
-            qDebug() << "Admin not found for group:" << groupId;
-        }
-    } else {
-        qDebug() << "SQL Error:" << query.lastError().text();
-    }
-
-    return QPair<QString, QString>(name, email);
-}
-
-bool ChatDatabaseHandler::updateGroupName(const QString &oldName, const QString &newName)
-{
-    if (!dbInitialized) return false;
-
-    QSqlQuery query(db);
-    query.prepare("UPDATE chat_groups SET name = :newName WHERE name = :oldName");
-    query.bindValue(":newName", newName);
-    query.bindValue(":oldName", oldName);
-
-    if (!query.exec()) {
-        qDebug() << "Failed to update group name:" << query.lastError().text();
-        return false;
-    }
-
-    return query.numRowsAffected() > 0;
-}
-
-bool ChatDatabaseHandler::deleteGroup(const QString &groupId)
-{
-    QSqlDatabase::database().transaction();
-
-    // Delete group messages
-    QSqlQuery deleteMessages(QSqlDatabase::database());
-    deleteMessages.prepare("DELETE FROM messages WHERE chatgroup_id = :groupId");
-    deleteMessages.bindValue(":groupId", groupId);
-    if (!deleteMessages.exec()) {
-        QSqlDatabase::database().rollback();
-        qDebug() << "Failed to delete group messages:" << deleteMessages.lastError();
-        return false;
-    }
-
-    // Delete group memberships
-    QSqlQuery deleteMembers(QSqlDatabase::database());
-    deleteMembers.prepare("DELETE FROM user_chat_groups WHERE chatgroup_id = :groupId");
-    deleteMembers.bindValue(":groupId", groupId);
-    if (!deleteMembers.exec()) {
-        QSqlDatabase::database().rollback();
-        qDebug() << "Failed to delete group members:" << deleteMembers.lastError();
-        return false;
-    }
-
-    // Delete the group itself
-    QSqlQuery deleteGroup(QSqlDatabase::database());
-    deleteGroup.prepare("DELETE FROM chat_groups WHERE id = :groupId");
-    deleteGroup.bindValue(":groupId", groupId);
-    if (!deleteGroup.exec()) {
-        QSqlDatabase::database().rollback();
-        qDebug() << "Failed to delete group:" << deleteGroup.lastError();
-        return false;
-    }
-
-    return QSqlDatabase::database().commit();
-}
+// chatdbhandler.cpp
+#include "chatdbhandler.h"
+#include "dbmigrations.h"
+#include "messagetime.h"
+
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFileInfo>
+#include <QTimeZone>
+#include <algorithm>
+#include <limits>
+
+namespace {
+
+// Resets a cached statement when it goes out of scope, so a reused
+// query never keeps a read cursor open between calls.
+class StatementReset
+{
+public:
+    explicit StatementReset(QSqlQuery &query) : query(query) {}
+    ~StatementReset() { query.finish(); }
+
+private:
+    QSqlQuery &query;
+};
+
+// Page anchor used by the keyset queries; "before nothing" means the newest page
+qint64 pageAnchor(qint64 anchorId, ChatDatabaseHandler::PageDirection direction)
+{
+    if (direction == ChatDatabaseHandler::PageDirection::Before && anchorId <= 0) {
+        return std::numeric_limits<qint64>::max();
+    }
+    return anchorId;
+}
+
+// Cache id of a page statement on one tier; detaching an archive drops the
+// statements whose id ends in its schema name
+QString pageStatementId(const QString &name, const QString &schema, ChatDatabaseHandler::PageDirection direction)
+{
+    return QString("%1%2@%3").arg(name, direction == ChatDatabaseHandler::PageDirection::Before ? "Before" : "After", schema);
+}
+
+// MessageBatch columns, the sender is resolved once per batch
+QString messageBatchColumns()
+{
+    return "m.id, m.sender_id, m.content, m.timestamp, " + messageTypeSql("m.type");
+}
+
+// Keyset page of a direct conversation. In the main database that is one
+// range on (conversation_id, id). Archive files have no conversation ids,
+// so there each direction of the conversation is its own range on
+// (sender_id, recipient_id, id) and a page reads at most 2 * limit index entries.
+QString directPageSql(const QString &schema, ChatDatabaseHandler::PageDirection direction,
+                      const QString &columns, const QString &joins)
+{
+    bool before = direction == ChatDatabaseHandler::PageDirection::Before;
+    if (schema == "main") {
+        return QString("SELECT %1 FROM main.messages m "
+                       "%2"
+                       "WHERE m.conversation_id = :conversation AND m.id %3 :anchor "
+                       "ORDER BY m.id %4 LIMIT :limit")
+            .arg(columns, joins, before ? "<" : ">", before ? "DESC" : "ASC");
+    }
+    return QString("SELECT %2 FROM ("
+                   "  SELECT id FROM (SELECT id FROM %1.messages "
+                   "                  WHERE sender_id = :user1 AND recipient_id = :user2 AND id %4 :anchor "
+                   "                  ORDER BY id %5 LIMIT :limit) "
+                   "  UNION ALL "
+                   "  SELECT id FROM (SELECT id FROM %1.messages "
+                   "                  WHERE sender_id = :user2 AND recipient_id = :user1 AND id %4 :anchor "
+                   "                  ORDER BY id %5 LIMIT :limit)"
+                   ") page "
+                   "JOIN %1.messages m ON m.id = page.id "
+                   "%3"
+                   "ORDER BY m.id %5 LIMIT :limit")
+        .arg(schema, columns, joins, before ? "<" : ">", before ? "DESC" : "ASC");
+}
+
+// Keyset page of a group, a range scan on (chatgroup_id, id)
+QString groupPageSql(const QString &schema, ChatDatabaseHandler::PageDirection direction,
+                     const QString &columns, const QString &joins)
+{
+    bool before = direction == ChatDatabaseHandler::PageDirection::Before;
+    return QString("SELECT %2 FROM %1.messages m "
+                   "%3"
+                   "WHERE m.chatgroup_id = :group_id AND m.id %4 :anchor "
+                   "ORDER BY m.id %5 LIMIT :limit")
+        .arg(schema, columns, joins, before ? "<" : ">", before ? "DESC" : "ASC");
+}
+
+// Turns what the user typed into an FTS5 query: every word must match,
+// the last one as a prefix so results follow the typing. Words are
+// quoted, so FTS5 operators and punctuation are matched literally.
+QString ftsQuery(const QString &text)
+{
+    const QStringList words = text.simplified().split(' ', Qt::SkipEmptyParts);
+    QStringList terms;
+    for (const QString &word : words) {
+        QString escaped = word;
+        escaped.replace('"', "\"\"");
+        terms.append('"' + escaped + '"');
+    }
+    if (!terms.isEmpty()) {
+        terms.last().append('*');
+    }
+    return terms.join(' ');
+}
+
+}
+
+// Times one operation from construction to the end of its scope
+class ChatDatabaseHandler::OperationProbe
+{
+public:
+    OperationProbe(const ChatDatabaseHandler *handler, QueryHistogram &histogram)
+        : handler(handler), histogram(histogram), rows(0), firstStatement(int(handler->probedStatements.size()))
+    {
+        ++handler->probeDepth;
+        timer.start();
+    }
+
+    ~OperationProbe()
+    {
+        qint64 nsecs = timer.nsecsElapsed();
+        histogram.record(nsecs, rows);
+
+        int slowQueryMs = handler->connectionProfile.slowQueryMs;
+        if (slowQueryMs > 0 && nsecs >= qint64(slowQueryMs) * 1000000) {
+            handler->explainSlowOperation(histogram.name(), nsecs, rows, firstStatement);
+        }
+        if (--handler->probeDepth == 0) {
+            handler->probedStatements.clear();
+        }
+    }
+
+    void setRows(qint64 count) { rows = count; }
+
+private:
+    const ChatDatabaseHandler *handler;
+    QueryHistogram &histogram;
+    qint64 rows;
+    int firstStatement;
+    QElapsedTimer timer;
+};
+
+ChatDatabaseHandler::ChatDatabaseHandler(QObject *parent)
+    : QObject(parent), databaseName("chat_database.db"), readOnly(false), dbInitialized(false), connectionProfile(ConnectionProfile::fromConfig()),
+      stmtCacheHits(0), stmtCacheMisses(0), inTransaction(false),
+      seenDataVersion(-1), seenMessageId(0), seenGroupChanges(0), probeDepth(0)
+{
+    setUserCacheCapacity(0);
+}
+
+ChatDatabaseHandler::~ChatDatabaseHandler()
+{
+    // Prepared statements must be released before the connection closes
+    clearStatementCache();
+
+    if (db.isOpen()) {
+        db.close();
+    }
+
+    if (dbInitialized) {
+        QString name = db.connectionName();
+        db = QSqlDatabase();
+        QSqlDatabase::removeDatabase(name);
+    }
+}
+
+bool ChatDatabaseHandler::initialize()
+{
+    // Check if db is already initialized
+    if (dbInitialized) {
+        return true;
+    }
+
+    // Setup connection
+    db = connectionName.isEmpty() ? QSqlDatabase::addDatabase("QSQLITE")
+                                  : QSqlDatabase::addDatabase("QSQLITE", connectionName);
+    db.setDatabaseName(databaseName);
+    if (readOnly) {
+        db.setConnectOptions("QSQLITE_OPEN_READONLY");
+    }
+
+    if (!db.open()) {
+        qDebug() << "Failed to open database:" << db.lastError().text();
+        return false;
+    }
+
+    // Monthly archives are kept next to the database file
+    archiveDirectory = QFileInfo(db.databaseName()).absolutePath();
+
+    // Journaling, sync and cache settings for this connection
+    connectionProfile.apply(db, readOnly);
+
+    // Bring older databases up to the current schema (the writer's job)
+    if (!readOnly && !runSchemaMigrations(db)) {
+        qDebug() << "Failed to migrate database schema";
+        db.close();
+        return false;
+    }
+
+    // Large message bodies are compressed on insert, with the newest shared
+    // dictionary if enabled. Readers load dictionaries when they meet one.
+    codec.setThreshold(connectionProfile.compressAbove);
+    if (!readOnly && connectionProfile.compressionDictionary) {
+        QSqlQuery query(db);
+        if (query.exec("SELECT id, dictionary FROM content_dictionaries ORDER BY id DESC LIMIT 1") && query.next()) {
+            codec.addDictionary(query.value(0).toInt(), query.value(1).toByteArray());
+            codec.setActiveDictionary(query.value(0).toInt());
+        }
+    }
+
+    dbInitialized = true;
+
+    // Changes from other processes count from here
+    if (!readOnly) {
+        checkExternalChanges();
+    }
+    return true;
+}
+
+QSqlQuery &ChatDatabaseHandler::cachedQuery(const QString &id, const QString &sql) const
+{
+    if (probeDepth > 0) {
+        probedStatements.append(sql);
+    }
+
+    auto it = statementCache.constFind(id);
+    if (it != statementCache.constEnd()) {
+        ++stmtCacheHits;
+        return **it;
+    }
+
+    ++stmtCacheMisses;
+
+    // Prepare once and keep the statement for the lifetime of the connection
+    QSqlQuery *query = new QSqlQuery(db);
+    query->setForwardOnly(true);
+    if (!query->prepare(sql)) {
+        qDebug() << "Failed to prepare statement" << id << ":" << query->lastError().text();
+    }
+    statementCache.insert(id, query);
+    return *query;
+}
+
+void ChatDatabaseHandler::explainSlowOperation(const char *name, qint64 nsecs, qint64 rows, int firstStatement) const
+{
+    QueryStats::SlowOperation slow;
+    slow.time = QDateTime::currentDateTime();
+    slow.name = QString::fromLatin1(name);
+    slow.connection = db.connectionName();
+    slow.nsecs = nsecs;
+    slow.rows = rows;
+
+    qDebug().noquote() << QString("Slow operation %1: %2 ms, %3 rows on %4")
+                              .arg(slow.name)
+                              .arg(nsecs / 1e6, 0, 'f', 1)
+                              .arg(rows)
+                              .arg(slow.connection);
+
+    // Parameters stay unbound, which doesn't change the plan
+    QStringList statements = probedStatements.mid(firstStatement);
+    statements.removeDuplicates();
+    for (const QString &sql : statements) {
+        QString plan = sql;
+        QSqlQuery explain(db);
+        if (explain.exec("EXPLAIN QUERY PLAN " + sql)) {
+            while (explain.next()) {
+                plan += "\n    " + explain.value(3).toString();
+            }
+        } else {
+            plan += "\n    (no plan: " + explain.lastError().text() + ")";
+        }
+        qDebug().noquote() << "  " + plan;
+        slow.plans.append(plan);
+    }
+
+    QueryStats::recordSlow(slow);
+}
+
+void ChatDatabaseHandler::clearStatementCache()
+{
+    qDeleteAll(statementCache);
+    statementCache.clear();
+}
+
+void ChatDatabaseHandler::setUserCacheCapacity(int maxUsers)
+{
+    // Bounded mode evicts the least recently used identities first
+    userCache.setMaxCost(maxUsers > 0 ? maxUsers : std::numeric_limits<qsizetype>::max());
+}
+
+bool ChatDatabaseHandler::lookupUser(const QString &email, int *userId, QString *userName) const
+{
+    if (const CachedUser *cached = userCache.object(email)) {
+        if (userId) *userId = cached->id;
+        if (userName) *userName = cached->name;
+        return true;
+    }
+
+    if (!dbInitialized) {
+        return false;
+    }
+
+    QSqlQuery &query = cachedQuery("userByEmail", "SELECT id, name FROM users WHERE email = :email");
+    StatementReset reset(query);
+    query.bindValue(":email", email);
+
+    if (!query.exec() || !query.next()) {
+        return false; // Unknown users are not cached
+    }
+
+    CachedUser *user = new CachedUser{query.value(0).toInt(), query.value(1).toString()};
+    if (userId) *userId = user->id;
+    if (userName) *userName = user->name;
+    userCache.insert(email, user);
+    return true;
+}
+
+bool ChatDatabaseHandler::executeQuery(const QString &sql)
+{
+    if (!dbInitialized) {
+        qDebug() << "Database not initialized";
+        return false;
+    }
+
+    QSqlQuery query(db);
+    if (!query.exec(sql)) {
+        qDebug() << "Query failed:" << query.lastError().text();
+        qDebug() << "SQL:" << sql;
+        return false;
+    }
+    return true;
+}
+
+bool ChatDatabaseHandler::checkTableExists(const QString &tableName)
+{
+    if (!dbInitialized) {
+        return false;
+    }
+
+    QSqlQuery &query = cachedQuery("tableExists",
+                                   "SELECT name FROM sqlite_master WHERE type='table' AND name=:name");
+    StatementReset reset(query);
+    query.bindValue(":name", tableName);
+
+    if (query.exec() && query.next()) {
+        return true;
+    }
+    return false;
+}
+
+QString ChatDatabaseHandler::loginUser(const QString &email, const QString &password)
+{
+    static QueryHistogram &histogram = QueryStats::histogram("loginUser");
+    OperationProbe probe(this, histogram);
+
+    if (!dbInitialized) {
+        qDebug() << "Database not initialized";
+        return QString(); // Return empty string on failure
+    }
+
+    QSqlQuery &query = cachedQuery("loginUser",
+                                   "SELECT id, name FROM users WHERE email = :email AND password = :password");
+    StatementReset reset(query);
+    query.bindValue(":email", email);
+    query.bindValue(":password", password); // In real app, use hashed passwords
+
+    if (query.exec() && query.next()) {
+        QString userName = query.value(1).toString();
+        userCache.insert(email, new CachedUser{query.value(0).toInt(), userName});
+        qDebug() << "Login successful for user:" << userName;
+        return userName;
+    }
+
+    qDebug() << "Login failed for email:" << email;
+    return QString(); // Return empty string if login fails
+}
+
+bool ChatDatabaseHandler::registerUser(const QString &username, const QString &email, const QString &password)
+{
+    static QueryHistogram &histogram = QueryStats::histogram("registerUser");
+    OperationProbe probe(this, histogram);
+
+    if (!dbInitialized) {
+        return false;
+    }
+    // Check if username already exists
+    QSqlQuery &checkQuery = cachedQuery("userByNameOrEmail",
+                                        "SELECT id FROM users WHERE name = :username OR email = :email");
+    StatementReset checkReset(checkQuery);
+    checkQuery.bindValue(":username", username);
+    checkQuery.bindValue(":email", email);
+    if (checkQuery.exec() && checkQuery.next()) {
+        return false; // Username or email already exists
+    }
+    checkQuery.finish();
+
+    // Create new user
+    QSqlQuery &insertQuery = cachedQuery("insertUser",
+                                         "INSERT INTO users (name, email, password) VALUES (:username, :email, :password)");
+    StatementReset insertReset(insertQuery);
+    insertQuery.bindValue(":username", username);
+    insertQuery.bindValue(":email", email);
+    insertQuery.bindValue(":password", password); // In real app, hash passwords
+    if (!insertQuery.exec()) {
+        return false;
+    }
+
+    // Drop any stale identity for this email
+    userCache.remove(email);
+    return true;
+}
+
+QString ChatDatabaseHandler::userExists(const QString & email) {
+    static QueryHistogram &histogram = QueryStats::histogram("userExists");
+    OperationProbe probe(this, histogram);
+
+    if (!dbInitialized) {
+        return QString();
+    }
+
+    QString userName;
+    if (lookupUser(email, nullptr, &userName)) {
+        return userName; // User exists
+    }
+    return QString();
+
+}
+
+QString ChatDatabaseHandler::groupChatExists(const QString & chatId) {
+    static QueryHistogram &histogram = QueryStats::histogram("groupChatExists");
+    OperationProbe probe(this, histogram);
+
+    if (!dbInitialized) {
+        return QString();
+    }
+
+
+    QSqlQuery &query = cachedQuery("groupNameById", "SELECT name FROM chat_groups WHERE id = :chatId");
+    StatementReset reset(query);
+    query.bindValue(":chatId", chatId);
+
+
+    if (query.exec() && query.next()) {
+
+        return query.value(0).toString(); // Group exists
+    }
+    return QString();
+
+}
+
+
+
+
+int ChatDatabaseHandler::createGroupChat(const QString &name, const QString &creatorEmail)
+{
+    static QueryHistogram &histogram = QueryStats::histogram("createGroupChat");
+    OperationProbe probe(this, histogram);
+
+    if (!dbInitialized) {
+        return -1; // Return -1 to indicate failure
+    }
+
+
+    // First, find the user ID for the given email
+    int creatorId;
+    if (!lookupUser(creatorEmail, &creatorId)) {
+        return -1; // No user found with this email
+    }
+
+
+    // Check if group already exists
+    // QSqlQuery checkQuery(db);
+    // checkQuery.prepare("SELECT id FROM chat_groups WHERE name = :name");
+    // checkQuery.bindValue(":name", name);
+    // if (checkQuery.exec() && checkQuery.next()) {
+    //     return checkQuery.value(0).toInt(); // Return existing group ID
+    // }
+
+    // The group and its creator's membership are written together
+    if (!db.transaction()) {
+        qDebug() << "Failed to begin transaction:" << db.lastError().text();
+        return -1;
+    }
+
+    // Create new group, the creator is its first member
+    QSqlQuery &insertQuery = cachedQuery("insertGroup",
+                                         "INSERT INTO chat_groups (name, created_at, created_by, member_count) "
+                                         "VALUES (:name, :created_at, :created_by, 1)");
+    StatementReset insertReset(insertQuery);
+    insertQuery.bindValue(":name", name);
+    insertQuery.bindValue(":created_at", QDateTime::currentDateTime().toString("yyyy-MM-dd hh:mm:ss"));
+    insertQuery.bindValue(":created_by", creatorId);
+
+    if (!insertQuery.exec()) {
+        db.rollback();
+        return -1; // Return -1 if insertion fails
+    }
+
+    // Get the ID of the newly created group
+    int newGroupId = insertQuery.lastInsertId().toInt();
+
+    // Automatically add the creator to the group
+    QSqlQuery &addCreatorQuery = cachedQuery("insertMembership",
+                                             "INSERT INTO user_chat_groups (user_id, chatgroup_id) VALUES (:user_id, :group_id)");
+    StatementReset addCreatorReset(addCreatorQuery);
+    addCreatorQuery.bindValue(":user_id", creatorId);
+    addCreatorQuery.bindValue(":group_id", newGroupId);
+
+    if (!addCreatorQuery.exec()) {
+        // Don't leave a group without its creator behind
+        db.rollback();
+        return -1;
+    }
+
+    if (!db.commit()) {
+        qDebug() << "Failed to create group:" << db.lastError().text();
+        db.rollback();
+        return -1;
+    }
+    emit membershipChanged(newGroupId, creatorEmail, true);
+    return newGroupId;
+}
+
+
+bool ChatDatabaseHandler::joinGroupChat(const QString &userEmail, const QString &groupId)
+{
+    static QueryHistogram &histogram = QueryStats::histogram("joinGroupChat");
+    OperationProbe probe(this, histogram);
+
+    if (!dbInitialized) {
+        return false;
+    }
+
+    // Get user ID
+    int userId;
+    if (!lookupUser(userEmail, &userId)) {
+        return false; // User not found
+    }
+
+    // Check if user is already in the group
+    QSqlQuery &checkQuery = cachedQuery("membershipExists",
+                                        "SELECT user_id FROM user_chat_groups WHERE user_id = :user_id AND chatgroup_id = :group_id");
+    StatementReset checkReset(checkQuery);
+    checkQuery.bindValue(":user_id", userId);
+    checkQuery.bindValue(":group_id", groupId);
+
+    if (checkQuery.exec() && checkQuery.next()) {
+        return true; // User is already in the group
+    }
+    checkQuery.finish();
+
+    // Membership and member count change together
+    if (!db.transaction()) {
+        qDebug() << "Failed to begin transaction:" << db.lastError().text();
+        return false;
+    }
+
+    // Add user to group
+    QSqlQuery &joinQuery = cachedQuery("insertMembership",
+                                       "INSERT INTO user_chat_groups (user_id, chatgroup_id) VALUES (:user_id, :group_id)");
+    StatementReset joinReset(joinQuery);
+    joinQuery.bindValue(":user_id", userId);
+    joinQuery.bindValue(":group_id", groupId);
+
+    if (!joinQuery.exec()) {
+        db.rollback();
+        return false;
+    }
+
+    QSqlQuery &countQuery = cachedQuery("incrementMemberCount",
+                                        "UPDATE chat_groups SET member_count = member_count + 1 WHERE id = :group_id");
+    StatementReset countReset(countQuery);
+    countQuery.bindValue(":group_id", groupId);
+
+    if (!countQuery.exec()) {
+        qDebug() << "Failed to update member count:" << countQuery.lastError().text();
+        db.rollback();
+        return false;
+    }
+
+    // The group may have been deleted since the caller checked it exists
+    if (countQuery.numRowsAffected() != 1) {
+        qDebug() << "Group" << groupId << "no longer exists";
+        db.rollback();
+        return false;
+    }
+
+    // History from before the join counts as read, as migration 8 does for
+    // existing members, so a big group doesn't flood the new member's inbox
+    QSqlQuery &readQuery = cachedQuery("joinGroupRead",
+                                       "INSERT INTO conversation_reads (conversation_id, user_id, last_read_message_id, read_count) "
+                                       "SELECT id, :user, last_message_id, message_count FROM conversations "
+                                       "WHERE chatgroup_id = :group_id "
+                                       "ON CONFLICT (conversation_id, user_id) DO NOTHING");
+    StatementReset readReset(readQuery);
+    readQuery.bindValue(":user", userId);
+    readQuery.bindValue(":group_id", groupId);
+
+    if (!readQuery.exec()) {
+        qDebug() << "Failed to set read cursor:" << readQuery.lastError().text();
+        db.rollback();
+        return false;
+    }
+
+    if (!db.commit()) {
+        return false;
+    }
+    emit membershipChanged(groupId.toInt(), userEmail, true);
+    return true;
+}
+
+QStringList ChatDatabaseHandler::getUserGroups(const QString &userEmail) const
+{
+    static QueryHistogram &histogram = QueryStats::histogram("getUserGroups");
+    OperationProbe probe(this, histogram);
+
+    QStringList groups;
+
+    if (!dbInitialized) {
+        return groups;
+    }
+
+    QSqlQuery &query = cachedQuery("userGroups",
+                                   "SELECT g.name FROM chat_groups g "
+                                   "JOIN user_chat_groups ug ON g.id = ug.chatgroup_id "
+                                   "JOIN users u ON u.id = ug.user_id "
+                                   "WHERE u.email = :userEmail "
+                                   "ORDER BY g.name");
+    StatementReset reset(query);
+    query.bindValue(":userEmail", userEmail);
+
+    if (query.exec()) {
+        while (query.next()) {
+            groups << query.value(0).toString();
+        }
+    }
+
+    probe.setRows(groups.size());
+    return groups;
+}
+
+QList<QPair<QString, QString>> ChatDatabaseHandler::getGroupChatMembers(const QString &chatName) {
+    return getGroupChatMembers(lookupGroupId(chatName));
+}
+
+QList<QPair<QString, QString>> ChatDatabaseHandler::getGroupChatMembers(int groupId) {
+    static QueryHistogram &histogram = QueryStats::histogram("getGroupChatMembers");
+    OperationProbe probe(this, histogram);
+
+    QList<QPair<QString, QString>> members;
+    if (!dbInitialized || groupId < 0) {
+        return members;
+    }
+
+    // Seek on idx_user_chat_groups_group
+    QSqlQuery &query = cachedQuery("groupMembers",
+                                   "SELECT u.name, u.email FROM user_chat_groups ug "
+                                   "JOIN users u ON u.id = ug.user_id "
+                                   "WHERE ug.chatgroup_id = :group_id "
+                                   "ORDER BY u.name");
+    StatementReset reset(query);
+    query.bindValue(":group_id", groupId);
+
+    if (query.exec()) {
+        while (query.next()) {
+            QString name = query.value(0).toString();
+            QString email = query.value(1).toString();
+            members.append(QPair<QString, QString>(name, email));
+        }
+    } else {
+        qDebug() << "Error fetching group members:" << query.lastError().text();
+    }
+
+    probe.setRows(members.size());
+    return members;
+}
+
+bool ChatDatabaseHandler::sendDirectMessage(const QString &sender, const QString &recipient, const QString &content)
+{
+    return insertDirectMessage(sender, recipient, content) >= 0;
+}
+
+qint64 ChatDatabaseHandler::insertDirectMessage(const QString &sender, const QString &recipient, const QString &content)
+{
+    static QueryHistogram &histogram = QueryStats::histogram("insertDirectMessage");
+    OperationProbe probe(this, histogram);
+
+    if (!dbInitialized || content.isEmpty()) {
+        return -1;
+    }
+
+    // Get sender ID
+    int senderId;
+    if (!lookupUser(sender, &senderId)) {
+        qDebug() << "Sender not found:" << sender;
+        return -1; // Sender not found
+    }
+
+    // Get recipient ID
+    int recipientId;
+    if (!lookupUser(recipient, &recipientId)) {
+        qDebug() << "Recipient not found:" << recipient;
+        return -1; // Recipient not found
+    }
+
+    // The first message of a conversation gets its id from the insert trigger
+    qint64 conversationId = lookupDirectConversation(senderId, recipientId);
+
+    // Send message
+    QSqlQuery &messageQuery = cachedQuery("insertDirectMessage",
+                                          "INSERT INTO messages (sender_id, chatgroup_id, recipient_id, content, timestamp, conversation_id) "
+                                          "VALUES (:sender_id, NULL, :recipient_id, :content, :timestamp, :conversation_id)");
+    StatementReset messageReset(messageQuery);
+    QVariant storedContent = codec.encode(content);
+    messageQuery.bindValue(":sender_id", senderId);
+    messageQuery.bindValue(":recipient_id", recipientId);
+    messageQuery.bindValue(":conversation_id", conversationId > 0 ? QVariant(conversationId) : QVariant());
+    messageQuery.bindValue(":content", storedContent);
+    messageQuery.bindValue(":timestamp", currentStoredTimestamp());
+
+    // The full-text trigger only indexes plain text rows
+    bool indexed = storedContent.typeId() == QMetaType::QByteArray;
+    if (indexed && !beginIndexedInsert()) {
+        return -1;
+    }
+
+    if (!messageQuery.exec()) {
+        qDebug() << "Failed to insert message:" << messageQuery.lastError().text();
+        if (indexed) {
+            endIndexedInsert(false);
+        }
+        return -1;
+    }
+
+    qint64 messageId = messageQuery.lastInsertId().toLongLong();
+    if (indexed && !endIndexedInsert(indexCompressedContent(messageId, content))) {
+        return -1;
+    }
+    notifyCommitted([this, messageId, sender, recipient]() {
+        emit messageInserted(messageId, -1, sender, recipient);
+    });
+    return messageId;
+}
+
+bool ChatDatabaseHandler::sendGroupMessage(const QString &sender, const QString &groupId,
+                                           const QString &content, const QString &type)
+{
+    return insertGroupMessage(sender, groupId, content, type) >= 0;
+}
+
+qint64 ChatDatabaseHandler::insertGroupMessage(const QString &sender, const QString &groupId,
+                                               const QString &content, const QString &type)
+{
+    // Get group ID - now using id directly if it's a number, otherwise query by name
+    int groupIdInt;
+    bool isNumber;
+    groupIdInt = groupId.toInt(&isNumber);
+
+    if (!isNumber) {
+        groupIdInt = lookupGroupId(groupId);
+        if (groupIdInt < 0) {
+            qDebug() << "group not found:" << groupId;
+            return -1; // Group not found
+        }
+    }
+
+    return insertGroupMessage(sender, groupIdInt, content, type);
+}
+
+qint64 ChatDatabaseHandler::insertGroupMessage(const QString &sender, int groupIdInt,
+                                               const QString &content, const QString &type)
+{
+    static QueryHistogram &histogram = QueryStats::histogram("insertGroupMessage");
+    OperationProbe probe(this, histogram);
+
+    if (!dbInitialized || content.isEmpty()) {
+        return -1;
+    }
+
+    // Get sender ID
+    int senderId;
+    if (!lookupUser(sender, &senderId)) {
+        qDebug() << sender;
+
+        return -1; // Sender not found
+    }
+
+    // Send message
+    QSqlQuery &messageQuery = cachedQuery("insertGroupMessage",
+                                          "INSERT INTO messages (sender_id, chatgroup_id, recipient_id, content, timestamp, type) "
+                                          "VALUES (:sender_id, :group_id, NULL, :content, :timestamp, :type)");
+    StatementReset messageReset(messageQuery);
+    QVariant storedContent = codec.encode(content);
+    messageQuery.bindValue(":sender_id", senderId);
+    messageQuery.bindValue(":group_id", groupIdInt);
+    messageQuery.bindValue(":content", storedContent);
+    messageQuery.bindValue(":timestamp", currentStoredTimestamp());
+    messageQuery.bindValue(":type", type);
+
+    // The full-text trigger only indexes plain text rows, and never system messages
+    bool indexed = storedContent.typeId() == QMetaType::QByteArray && type != "system";
+    if (indexed && !beginIndexedInsert()) {
+        return -1;
+    }
+
+    if (!messageQuery.exec()) {
+        qDebug() << "Failed to send message:" << messageQuery.lastError().text();
+        if (indexed) {
+            endIndexedInsert(false);
+        }
+        return -1;
+    }
+
+    qint64 messageId = messageQuery.lastInsertId().toLongLong();
+    if (indexed && !endIndexedInsert(indexCompressedContent(messageId, content))) {
+        return -1;
+    }
+    notifyCommitted([this, messageId, groupIdInt, sender]() {
+        emit messageInserted(messageId, groupIdInt, sender, QString());
+    });
+    return messageId;
+}
+
+bool ChatDatabaseHandler::beginIndexedInsert()
+{
+    // Outside a transaction the savepoint is one of its own
+    QSqlQuery query(db);
+    if (!query.exec("SAVEPOINT indexed_insert")) {
+        qDebug() << "Failed to begin message insert:" << query.lastError().text();
+        return false;
+    }
+    return true;
+}
+
+bool ChatDatabaseHandler::endIndexedInsert(bool keep)
+{
+    QSqlQuery query(db);
+    if (keep && query.exec("RELEASE indexed_insert")) {
+        return true;
+    }
+    if (keep) {
+        qDebug() << "Failed to commit message insert:" << query.lastError().text();
+    }
+
+    // Undo the row without touching the rest of a batch
+    if (!query.exec("ROLLBACK TO indexed_insert") || !query.exec("RELEASE indexed_insert")) {
+        qDebug() << "Failed to undo message insert:" << query.lastError().text();
+    }
+    return false;
+}
+
+bool ChatDatabaseHandler::indexCompressedContent(qint64 messageId, const QString &content)
+{
+    QSqlQuery &query = cachedQuery("indexCompressedMessage",
+                                   "INSERT INTO messages_fts (rowid, content) VALUES (:id, :content)");
+    StatementReset reset(query);
+    query.bindValue(":id", messageId);
+    query.bindValue(":content", content);
+    if (!query.exec()) {
+        qDebug() << "Failed to index compressed message" << messageId << ":" << query.lastError().text();
+        return false;
+    }
+    return true;
+}
+
+QString ChatDatabaseHandler::decodeContent(const QVariant &storedContent) const
+{
+    int dictionaryId = MessageCodec::dictionaryOf(storedContent);
+    if (dictionaryId >= 0 && !codec.hasDictionary(dictionaryId)) {
+        QSqlQuery &query = cachedQuery("compressionDictionary",
+                                       "SELECT dictionary FROM content_dictionaries WHERE id = :id");
+        StatementReset reset(query);
+        query.bindValue(":id", dictionaryId);
+        if (query.exec() && query.next()) {
+            codec.addDictionary(dictionaryId, query.value(0).toByteArray());
+        }
+    }
+    return codec.decode(storedContent);
+}
+
+int ChatDatabaseHandler::trainCompressionDictionary(int sampleCount)
+{
+    static QueryHistogram &histogram = QueryStats::histogram("trainCompressionDictionary");
+    OperationProbe probe(this, histogram);
+
+    if (!dbInitialized || readOnly) {
+        return -1;
+    }
+    if (!MessageCodec::dictionarySupported()) {
+        qDebug() << "Compression dictionaries need zlib support, which is not built in";
+        return -1;
+    }
+
+    // The dictionary is for the bodies that get compressed, so learn from recent ones
+    QList<QByteArray> samples;
+    {
+        QSqlQuery query(db);
+        query.setForwardOnly(true);
+        query.prepare("SELECT content FROM messages "
+                      "WHERE typeof(content) = 'blob' OR length(content) >= :min_size "
+                      "ORDER BY id DESC LIMIT :samples");
+        query.bindValue(":min_size", qMax(codec.compressThreshold(), 256));
+        query.bindValue(":samples", sampleCount);
+        if (!query.exec()) {
+            qDebug() << "Failed to sample messages for a compression dictionary:" << query.lastError().text();
+            return -1;
+        }
+        while (query.next()) {
+            samples.append(decodeContent(query.value(0)).toUtf8());
+        }
+    }
+
+    QByteArray dictionary = MessageCodec::trainDictionary(samples);
+    if (dictionary.isEmpty()) {
+        qDebug() << "Not enough repeated content in" << samples.size() << "messages to train a compression dictionary";
+        return -1;
+    }
+
+    QSqlQuery insert(db);
+    insert.prepare("INSERT INTO content_dictionaries (dictionary, created_at) VALUES (:dictionary, :created_at)");
+    insert.bindValue(":dictionary", dictionary);
+    insert.bindValue(":created_at", currentStoredTimestamp());
+    if (!insert.exec()) {
+        qDebug() << "Failed to store compression dictionary:" << insert.lastError().text();
+        return -1;
+    }
+
+    int id = insert.lastInsertId().toInt();
+    codec.addDictionary(id, dictionary);
+    codec.setActiveDictionary(id);
+    qDebug() << "Trained compression dictionary" << id << ":" << dictionary.size()
+             << "bytes from" << samples.size() << "messages";
+    return id;
+}
+
+ChatDatabaseHandler::CompressionReport ChatDatabaseHandler::compressionReport() const
+{
+    CompressionReport report = {0, 0, 0, 0};
+    if (!dbInitialized) {
+        return report;
+    }
+
+    QSqlQuery query(db);
+    query.setForwardOnly(true);
+    if (!query.exec("SELECT content FROM messages WHERE typeof(content) = 'blob'")) {
+        qDebug() << "Failed to read compressed messages:" << query.lastError().text();
+        return report;
+    }
+
+    QElapsedTimer timer;
+    while (query.next()) {
+        QVariant stored = query.value(0);
+        QByteArray blob = stored.toByteArray();
+        ++report.compressedRows;
+        report.storedBytes += blob.size();
+        report.plainBytes += qMax<qint64>(MessageCodec::plainSize(blob), 0);
+
+        timer.start();
+        decodeContent(stored);
+        report.decodeNsecs += timer.nsecsElapsed();
+    }
+    return report;
+}
+
+bool ChatDatabaseHandler::checkExternalChanges()
+{
+    static QueryHistogram &histogram = QueryStats::histogram("checkExternalChanges");
+    OperationProbe probe(this, histogram);
+
+    if (!dbInitialized || inTransaction) {
+        return false;
+    }
+
+    // data_version only moves when another connection commits
+    QSqlQuery &version = cachedQuery("dataVersion", "PRAGMA data_version");
+    StatementReset versionReset(version);
+    if (!version.exec() || !version.next()) {
+        qDebug() << "Failed to read data version:" << version.lastError().text();
+        return false;
+    }
+    qint64 dataVersion = version.value(0).toLongLong();
+    if (dataVersion == seenDataVersion) {
+        return false;
+    }
+    bool baseline = seenDataVersion < 0;
+    seenDataVersion = dataVersion;
+
+    QSqlQuery &groups = cachedQuery("groupChanges", "SELECT value FROM change_counters WHERE name = 'groups'");
+    StatementReset groupsReset(groups);
+    if (!groups.exec() || !groups.next()) {
+        qDebug() << "Failed to read group changes:" << groups.lastError().text();
+        return false;
+    }
+    qint64 groupChanges = groups.value(0).toLongLong();
+    bool groupsChanged = groupChanges != seenGroupChanges;
+    seenGroupChanges = groupChanges;
+
+    if (baseline) {
+        QSqlQuery &last = cachedQuery("lastMessageId", "SELECT COALESCE(MAX(id), 0) FROM messages");
+        StatementReset lastReset(last);
+        if (last.exec() && last.next()) {
+            seenMessageId = last.value(0).toLongLong();
+        }
+        return false;
+    }
+
+    // Newest new message of each conversation; SQLite takes the bare
+    // columns from the row with the MAX(id). Ids are handed out under the
+    // write lock, so they rise in commit order across processes.
+    QSqlQuery &messages = cachedQuery("externalMessages",
+                                      "SELECT MAX(m.id), m.chatgroup_id, s.email, r.email FROM messages m "
+                                      "JOIN users s ON s.id = m.sender_id "
+                                      "LEFT JOIN users r ON r.id = m.recipient_id "
+                                      "WHERE m.id > :since "
+                                      "GROUP BY m.chatgroup_id, m.conversation_id");
+    StatementReset messagesReset(messages);
+    messages.bindValue(":since", seenMessageId);
+    if (!messages.exec()) {
+        qDebug() << "Failed to read new messages:" << messages.lastError().text();
+        return false;
+    }
+    while (messages.next()) {
+        qint64 messageId = messages.value(0).toLongLong();
+        int groupId = messages.value(1).isNull() ? -1 : messages.value(1).toInt();
+        seenMessageId = qMax(seenMessageId, messageId);
+        emit messageInserted(messageId, groupId, messages.value(2).toString(), messages.value(3).toString());
+    }
+
+    if (groupsChanged) {
+        emit groupsChangedExternally();
+    }
+    return true;
+}
+
+bool ChatDatabaseHandler::beginTransaction()
+{
+    if (!dbInitialized || !db.transaction()) {
+        qDebug() << "Failed to begin transaction:" << db.lastError().text();
+        return false;
+    }
+    inTransaction = true;
+    return true;
+}
+
+bool ChatDatabaseHandler::commitTransaction()
+{
+    static QueryHistogram &histogram = QueryStats::histogram("commitTransaction");
+    OperationProbe probe(this, histogram);
+
+    if (!db.commit()) {
+        qDebug() << "Failed to commit transaction:" << db.lastError().text();
+        return false;
+    }
+    inTransaction = false;
+
+    // Taken first, a receiver may start the next transaction
+    const QList<std::function<void()>> notifications = std::move(pendingNotifications);
+    pendingNotifications.clear();
+    for (const auto &notification : notifications) {
+        notification();
+    }
+    return true;
+}
+
+void ChatDatabaseHandler::rollbackTransaction()
+{
+    if (!db.rollback()) {
+        qDebug() << "Failed to roll back transaction:" << db.lastError().text();
+    }
+    inTransaction = false;
+    pendingNotifications.clear();
+    directConversations.clear();
+}
+
+void ChatDatabaseHandler::notifyCommitted(std::function<void()> notification)
+{
+    if (inTransaction) {
+        pendingNotifications.append(std::move(notification));
+    } else {
+        notification();
+    }
+}
+
+int ChatDatabaseHandler::lookupGroupId(const QString &groupName) const
+{
+    QSqlQuery &query = cachedQuery("groupIdByName", "SELECT id FROM chat_groups WHERE name = :name");
+    StatementReset reset(query);
+    query.bindValue(":name", groupName);
+
+    if (query.exec() && query.next()) {
+        return query.value(0).toInt();
+    }
+    return -1;
+}
+
+qint64 ChatDatabaseHandler::lookupDirectConversation(int userId1, int userId2) const
+{
+    const QPair<int, int> users(qMin(userId1, userId2), qMax(userId1, userId2));
+    auto cached = directConversations.constFind(users);
+    if (cached != directConversations.constEnd()) {
+        return cached.value();
+    }
+
+    QSqlQuery &query = cachedQuery("directConversation",
+                                   "SELECT id FROM conversations WHERE user_low = :low AND user_high = :high");
+    StatementReset reset(query);
+    query.bindValue(":low", users.first);
+    query.bindValue(":high", users.second);
+
+    if (!query.exec() || !query.next()) {
+        return -1; // No messages yet, not cached
+    }
+    qint64 id = query.value(0).toLongLong();
+    directConversations.insert(users, id);
+    return id;
+}
+
+int ChatDatabaseHandler::readMessageBatch(QSqlQuery &query, MessageBatch &batch, qint64 *lastId) const
+{
+    int count = 0;
+    while (query.next()) {
+        batch.messages.push_back(Message{
+            query.value(0).toLongLong(),                   // message id
+            storedTimestampMsecs(query.value(3)),          // timestamp
+            decodeContent(query.value(2)),                 // content
+            batch.internSender(query.value(1).toInt()),    // sender
+            MessageType(query.value(4).toInt())            // type
+        });
+        *lastId = batch.messages.back().id;
+        ++count;
+    }
+    return count;
+}
+
+void ChatDatabaseHandler::resolveSenders(MessageBatch &batch) const
+{
+    // One lookup per distinct sender in the page
+    QSqlQuery &senderQuery = cachedQuery("userById", "SELECT name, email FROM users WHERE id = :id");
+    for (MessageSender &sender : batch.senders) {
+        StatementReset reset(senderQuery);
+        senderQuery.bindValue(":id", sender.id);
+        if (senderQuery.exec() && senderQuery.next()) {
+            sender.name = senderQuery.value(0).toString();
+            sender.email = senderQuery.value(1).toString();
+        }
+    }
+}
+
+MessageBatch ChatDatabaseHandler::getDirectMessageBatch(const QString &user1, const QString &user2,
+                                                        qint64 anchorId, PageDirection direction, int limit)
+{
+    static QueryHistogram &histogram = QueryStats::histogram("getDirectMessageBatch");
+    OperationProbe probe(this, histogram);
+
+    MessageBatch batch;
+    if (!dbInitialized) {
+        return batch;
+    }
+
+    int userId1;
+    int userId2;
+    if (!lookupUser(user1, &userId1) || !lookupUser(user2, &userId2)) {
+        return batch;
+    }
+
+    // Archived messages keep their conversations row, so no row means no messages
+    qint64 conversationId = lookupDirectConversation(userId1, userId2);
+    if (conversationId < 0) {
+        return batch;
+    }
+
+    batch.messages.reserve(qMax(limit, 0));
+    readTiered(anchorId, direction, limit, [&](const QString &schema, qint64 anchor, int remaining, qint64 *lastId) {
+        QSqlQuery &query = cachedQuery(pageStatementId("directBatch", schema, direction),
+                                       directPageSql(schema, direction, messageBatchColumns(), QString()));
+        StatementReset reset(query);
+        if (schema == "main") {
+            query.bindValue(":conversation", conversationId);
+        } else {
+            query.bindValue(":user1", userId1);
+            query.bindValue(":user2", userId2);
+        }
+        query.bindValue(":anchor", anchor);
+        query.bindValue(":limit", remaining);
+
+        if (!query.exec()) {
+            qDebug() << "Query failed:" << query.lastError().text();
+            return 0;
+        }
+        return readMessageBatch(query, batch, lastId);
+    });
+
+    if (direction == PageDirection::Before) {
+        std::reverse(batch.messages.begin(), batch.messages.end());
+    }
+    resolveSenders(batch);
+    probe.setRows(qint64(batch.messages.size()));
+    return batch;
+}
+
+MessageBatch ChatDatabaseHandler::getGroupMessageBatch(int groupId, qint64 anchorId, PageDirection direction, int limit)
+{
+    static QueryHistogram &histogram = QueryStats::histogram("getGroupMessageBatch");
+    OperationProbe probe(this, histogram);
+
+    MessageBatch batch;
+    if (!dbInitialized || groupId < 0) {
+        return batch;
+    }
+
+    batch.messages.reserve(qMax(limit, 0));
+    readTiered(anchorId, direction, limit, [&](const QString &schema, qint64 anchor, int remaining, qint64 *lastId) {
+        QSqlQuery &query = cachedQuery(pageStatementId("groupBatch", schema, direction),
+                                       groupPageSql(schema, direction, messageBatchColumns(), QString()));
+        StatementReset reset(query);
+        query.bindValue(":group_id", groupId);
+        query.bindValue(":anchor", anchor);
+        query.bindValue(":limit", remaining);
+
+        if (!query.exec()) {
+            qDebug() << "Query failed:" << query.lastError().text();
+            return 0;
+        }
+        return readMessageBatch(query, batch, lastId);
+    });
+
+    if (direction == PageDirection::Before) {
+        std::reverse(batch.messages.begin(), batch.messages.end());
+    }
+    resolveSenders(batch);
+    probe.setRows(qint64(batch.messages.size()));
+    return batch;
+}
+
+void ChatDatabaseHandler::readTiered(qint64 anchorId, PageDirection direction, int limit, const TierFetch &fetch)
+{
+    qint64 anchor = pageAnchor(anchorId, direction);
+    int remaining = limit;
+
+    auto readTier = [&](const QString &schema) {
+        qint64 lastId = anchor;
+        remaining -= fetch(schema, anchor, remaining, &lastId);
+        anchor = lastId;
+    };
+
+    if (direction == PageDirection::Before) {
+        // Newest first: the hot tables, then the archives from the newest month back.
+        // A page the hot tables fill never looks at the archives.
+        readTier("main");
+        if (remaining <= 0) {
+            return;
+        }
+        for (const ArchiveTier &tier : archiveTiers()) {
+            if (remaining <= 0) {
+                break;
+            }
+            if (tier.minId >= anchor) {
+                continue;
+            }
+            QString schema = attachArchive(tier);
+            if (!schema.isEmpty()) {
+                readTier(schema);
+            }
+        }
+    } else {
+        // Oldest first: archives holding ids past the anchor, then the hot tables
+        const QList<ArchiveTier> tiers = archiveTiers();
+        for (auto it = tiers.crbegin(); it != tiers.crend() && remaining > 0; ++it) {
+            if (it->maxId <= anchor) {
+                continue;
+            }
+            QString schema = attachArchive(*it);
+            if (!schema.isEmpty()) {
+                readTier(schema);
+            }
+        }
+        if (remaining > 0) {
+            readTier("main");
+        }
+    }
+}
+
+QList<ArchiveTier> ChatDatabaseHandler::archiveTiers() const
+{
+    QList<ArchiveTier> tiers;
+    QSqlQuery &query = cachedQuery("archiveTiers",
+                                   "SELECT month, file_name, min_id, max_id FROM message_archives ORDER BY max_id DESC");
+    StatementReset reset(query);
+    if (!query.exec()) {
+        qDebug() << "Failed to list message archives:" << query.lastError().text();
+        return tiers;
+    }
+
+    while (query.next()) {
+        tiers.append(ArchiveTier{query.value(0).toString(), query.value(1).toString(),
+                                 query.value(2).toLongLong(), query.value(3).toLongLong()});
+    }
+    return tiers;
+}
+
+QString ChatDatabaseHandler::attachArchive(const ArchiveTier &tier)
+{
+    QString schema = archiveSchemaName(tier.month);
+    int index = attachedArchives.indexOf(schema);
+    if (index >= 0) {
+        attachedArchives.move(index, attachedArchives.size() - 1);
+        return schema;
+    }
+
+    // SQLite allows 10 attached databases by default; the least recently used goes first
+    if (attachedArchives.size() >= maxAttachedArchives) {
+        detachArchive(attachedArchives.takeFirst());
+    }
+
+    QSqlQuery query(db);
+    query.prepare("ATTACH DATABASE :file AS " + schema);
+    query.bindValue(":file", QDir(archiveDirectory).filePath(tier.fileName));
+    if (!query.exec()) {
+        qDebug() << "Failed to attach message archive" << tier.fileName << ":" << query.lastError().text();
+        return QString();
+    }
+
+    attachedArchives.append(schema);
+    return schema;
+}
+
+void ChatDatabaseHandler::detachArchive(const QString &schema)
+{
+    // Statements prepared against the schema would fail once it is gone
+    const QString suffix = "@" + schema;
+    for (auto it = statementCache.begin(); it != statementCache.end();) {
+        if (it.key().endsWith(suffix)) {
+            delete it.value();
+            it = statementCache.erase(it);
+        } else {
+            ++it;
+        }
+    }
+
+    QSqlQuery query(db);
+    if (!query.exec("DETACH DATABASE " + schema)) {
+        qDebug() << "Failed to detach message archive" << schema << ":" << query.lastError().text();
+    }
+}
+
+qint64 ChatDatabaseHandler::archiveOldMessages(int days)
+{
+    static QueryHistogram &histogram = QueryStats::histogram("archiveOldMessages");
+    OperationProbe probe(this, histogram);
+
+    if (!dbInitialized || readOnly || days <= 0) {
+        return 0;
+    }
+
+    qint64 cutoff = currentStoredTimestamp() - qint64(days) * 24 * 60 * 60 * 1000;
+
+    // Everything below the oldest id that isn't past the cutoff moves, so
+    // the archived ids stay below every id left in messages. An old
+    // timestamp on a high id (bulk loads, clock steps) can't pull recent
+    // messages along with it.
+    qint64 lastId = 0;
+    {
+        QSqlQuery query(db);
+        query.prepare("SELECT id FROM messages WHERE timestamp >= :cutoff ORDER BY id LIMIT 1");
+        query.bindValue(":cutoff", cutoff);
+        if (!query.exec()) {
+            qDebug() << "Failed to find messages to archive:" << query.lastError().text();
+            return -1;
+        }
+        if (query.next()) {
+            lastId = query.value(0).toLongLong() - 1;
+        } else {
+            // Nothing is recent, every message moves
+            if (!query.exec("SELECT COALESCE(MAX(id), 0) FROM messages") || !query.next()) {
+                qDebug() << "Failed to find messages to archive:" << query.lastError().text();
+                return -1;
+            }
+            lastId = query.value(0).toLongLong();
+        }
+    }
+    if (lastId <= 0) {
+        return 0;
+    }
+
+    // Split the ids into months. A month never starts before the previous
+    // one ends, so tiers don't overlap even where timestamps go backwards.
+    QList<ArchiveTier> ranges;
+    QString month;
+    qint64 monthEnd = std::numeric_limits<qint64>::min();
+    const QList<ArchiveTier> existing = archiveTiers();
+    if (!existing.isEmpty()) {
+        month = existing.first().month;
+        monthEnd = QDateTime(archiveMonthEnd(month), QTime(0, 0), QTimeZone::utc()).toMSecsSinceEpoch();
+    }
+    {
+        QSqlQuery query(db);
+        query.setForwardOnly(true);
+        query.prepare("SELECT id, timestamp FROM messages WHERE id <= :last_id ORDER BY id");
+        query.bindValue(":last_id", lastId);
+        if (!query.exec()) {
+            qDebug() << "Failed to read messages to archive:" << query.lastError().text();
+            return -1;
+        }
+
+        while (query.next()) {
+            qint64 id = query.value(0).toLongLong();
+            qint64 timestamp = query.value(1).toLongLong();
+            if (timestamp >= monthEnd) {
+                month = QDateTime::fromMSecsSinceEpoch(timestamp, QTimeZone::utc()).date().toString("yyyy-MM");
+                monthEnd = QDateTime(archiveMonthEnd(month), QTime(0, 0), QTimeZone::utc()).toMSecsSinceEpoch();
+                ranges.append(ArchiveTier{month, archiveFileName(month), id, id});
+            } else if (ranges.isEmpty()) {
+                // Still within the newest existing archive
+                ranges.append(ArchiveTier{month, archiveFileName(month), id, id});
+            }
+            ranges.last().maxId = id;
+        }
+    }
+
+    qint64 moved = 0;
+    for (const ArchiveTier &range : ranges) {
+        QString schema = attachArchive(range);
+        if (schema.isEmpty()) {
+            return -1;
+        }
+
+        QSqlQuery query(db);
+        for (const QString &sql : archiveSchemaStatements(schema)) {
+            if (!query.exec(sql)) {
+                qDebug() << "Failed to create message archive" << range.fileName << ":" << query.lastError().text();
+                return -1;
+            }
+        }
+
+        // One transaction over both files. In WAL mode a crash can still
+        // commit the archive without the delete; the copy ignores rows that
+        // are already there, so the next sweep finishes the job.
+        if (!db.transaction()) {
+            qDebug() << "Failed to start archive transaction:" << db.lastError().text();
+            return -1;
+        }
+
+        QSqlQuery copy(db);
+        copy.prepare(QString("INSERT OR IGNORE INTO %1.messages "
+                             "(id, sender_id, chatgroup_id, recipient_id, content, timestamp, type) "
+                             "SELECT id, sender_id, chatgroup_id, recipient_id, content, timestamp, type "
+                             "FROM main.messages WHERE id BETWEEN :min_id AND :max_id").arg(schema));
+        copy.bindValue(":min_id", range.minId);
+        copy.bindValue(":max_id", range.maxId);
+
+        // Index entries come from the hot index, which has the text of compressed rows too
+        QSqlQuery index(db);
+        index.prepare(QString("INSERT INTO %1.messages_fts (rowid, content) "
+                              "SELECT rowid, content FROM main.messages_fts "
+                              "WHERE rowid BETWEEN :min_id AND :max_id "
+                              "AND rowid NOT IN (SELECT rowid FROM %1.messages_fts "
+                              "WHERE rowid BETWEEN :fts_min_id AND :fts_max_id)").arg(schema));
+        index.bindValue(":min_id", range.minId);
+        index.bindValue(":max_id", range.maxId);
+        index.bindValue(":fts_min_id", range.minId);
+        index.bindValue(":fts_max_id", range.maxId);
+
+        // archive_sweep tells the delete triggers to leave conversations alone
+        QSqlQuery remove(db);
+        remove.prepare("DELETE FROM main.messages WHERE id BETWEEN :min_id AND :max_id");
+        remove.bindValue(":min_id", range.minId);
+        remove.bindValue(":max_id", range.maxId);
+
+        QSqlQuery record(db);
+        record.prepare("INSERT INTO message_archives (month, file_name, min_id, max_id) "
+                       "VALUES (:month, :file_name, :min_id, :max_id) "
+                       "ON CONFLICT (month) DO UPDATE SET min_id = MIN(min_id, excluded.min_id), "
+                       "max_id = MAX(max_id, excluded.max_id)");
+        record.bindValue(":month", range.month);
+        record.bindValue(":file_name", range.fileName);
+        record.bindValue(":min_id", range.minId);
+        record.bindValue(":max_id", range.maxId);
+
+        if (!query.exec("INSERT INTO archive_sweep (active) VALUES (1)")
+            || !copy.exec() || !index.exec() || !remove.exec() || !record.exec()
+            || !query.exec("DELETE FROM archive_sweep")) {
+            qDebug() << "Failed to archive messages for" << range.month << ":"
+                     << query.lastError().text() << copy.lastError().text() << index.lastError().text()
+                     << remove.lastError().text() << record.lastError().text();
+            db.rollback();
+            return -1;
+        }
+
+        qint64 rows = remove.numRowsAffected();
+        if (!db.commit()) {
+            qDebug() << "Failed to commit message archive" << range.month << ":" << db.lastError().text();
+            db.rollback();
+            return -1;
+        }
+        moved += rows;
+    }
+
+    qDebug() << "Archived" << moved << "messages older than" << days << "days into" << ranges.size() << "monthly files";
+    return moved;
+}
+
+QString ChatDatabaseHandler::snippetHtml(const QString &snippet)
+{
+    // snippet() marks matches with \x02 and \x03 so the stored text can be
+    // escaped before the markers become tags
+    return snippet.toHtmlEscaped().replace(QChar(0x02), "<b>").replace(QChar(0x03), "</b>");
+}
+
+QList<ChatDatabaseHandler::SearchHit> ChatDatabaseHandler::readSearchHits(QSqlQuery &query) const
+{
+    QList<SearchHit> hits;
+
+    while (query.next()) {
+        hits.append(std::make_tuple(
+            query.value(0).toLongLong(),         // message id
+            query.value(1).toString(),           // sender name
+            query.value(2).toString(),           // sender email
+            snippetHtml(query.value(3).toString()), // snippet
+            fromStoredTimestamp(query.value(4)), // timestamp
+            query.value(5).toDouble()            // bm25 rank, lower is better
+        ));
+    }
+    return hits;
+}
+
+QList<ChatDatabaseHandler::SearchHit> ChatDatabaseHandler::searchTiered(int offset, int limit, const TierSearch &search)
+{
+    // Without archives the hot index pages by itself
+    const QList<ArchiveTier> tiers = archiveTiers();
+    if (tiers.isEmpty()) {
+        return search("main", offset, limit);
+    }
+
+    // Every tier has its own index: take the best offset + limit hits of
+    // each and merge them by rank
+    QList<SearchHit> hits = search("main", 0, offset + limit);
+    for (const ArchiveTier &tier : tiers) {
+        QString schema = attachArchive(tier);
+        if (!schema.isEmpty()) {
+            hits.append(search(schema, 0, offset + limit));
+        }
+    }
+
+    std::sort(hits.begin(), hits.end(), [](const SearchHit &a, const SearchHit &b) {
+        if (std::get<5>(a) != std::get<5>(b)) {
+            return std::get<5>(a) < std::get<5>(b);
+        }
+        return std::get<0>(a) > std::get<0>(b);
+    });
+    return hits.mid(offset, limit);
+}
+
+QList<ChatDatabaseHandler::SearchHit> ChatDatabaseHandler::searchDirectMessages(const QString &user1, const QString &user2,
+                                                                                const QString &text, int offset, int limit)
+{
+    static QueryHistogram &histogram = QueryStats::histogram("searchDirectMessages");
+    OperationProbe probe(this, histogram);
+
+    QString match = ftsQuery(text);
+    if (!dbInitialized || match.isEmpty()) {
+        return QList<SearchHit>();
+    }
+
+    int user1Id, user2Id;
+    if (!lookupUser(user1, &user1Id) || !lookupUser(user2, &user2Id)) {
+        return QList<SearchHit>();
+    }
+
+    QList<SearchHit> hits = searchTiered(offset, limit, [&](const QString &schema, int tierOffset, int tierLimit) {
+        QSqlQuery &query = cachedQuery("searchDirectMessages@" + schema,
+                                       QString("SELECT m.id, u.name, u.email, "
+                                               "snippet(messages_fts, 0, char(2), char(3), '...', 12), "
+                                               "m.timestamp, bm25(messages_fts) AS rank "
+                                               "FROM %1.messages_fts "
+                                               "JOIN %1.messages m ON m.id = messages_fts.rowid "
+                                               "JOIN main.users u ON u.id = m.sender_id "
+                                               "WHERE messages_fts MATCH :match "
+                                               "AND ((m.sender_id = :user1 AND m.recipient_id = :user2) "
+                                               "OR (m.sender_id = :user2b AND m.recipient_id = :user1b)) "
+                                               "ORDER BY rank, m.id DESC LIMIT :limit OFFSET :offset").arg(schema));
+        StatementReset reset(query);
+        query.bindValue(":match", match);
+        query.bindValue(":user1", user1Id);
+        query.bindValue(":user2", user2Id);
+        query.bindValue(":user2b", user2Id);
+        query.bindValue(":user1b", user1Id);
+        query.bindValue(":limit", tierLimit);
+        query.bindValue(":offset", tierOffset);
+
+        if (!query.exec()) {
+            qDebug() << "Failed to search direct messages:" << query.lastError().text();
+            return QList<SearchHit>();
+        }
+        return readSearchHits(query);
+    });
+    probe.setRows(hits.size());
+    return hits;
+}
+
+QList<ChatDatabaseHandler::SearchHit> ChatDatabaseHandler::searchGroupMessages(const QString &userEmail, const QString &groupName,
+                                                                               const QString &text, int offset, int limit)
+{
+    return searchGroupMessages(userEmail, lookupGroupId(groupName), text, offset, limit);
+}
+
+QList<ChatDatabaseHandler::SearchHit> ChatDatabaseHandler::searchGroupMessages(const QString &userEmail, int groupId,
+                                                                               const QString &text, int offset, int limit)
+{
+    static QueryHistogram &histogram = QueryStats::histogram("searchGroupMessages");
+    OperationProbe probe(this, histogram);
+
+    QString match = ftsQuery(text);
+    if (!dbInitialized || match.isEmpty()) {
+        return QList<SearchHit>();
+    }
+
+    // Non-members can't search a group's history
+    if (groupId < 0 || !isGroupMember(userEmail, groupId)) {
+        return QList<SearchHit>();
+    }
+
+    QList<SearchHit> hits = searchTiered(offset, limit, [&](const QString &schema, int tierOffset, int tierLimit) {
+        QSqlQuery &query = cachedQuery("searchGroupMessages@" + schema,
+                                       QString("SELECT m.id, u.name, u.email, "
+                                               "snippet(messages_fts, 0, char(2), char(3), '...', 12), "
+                                               "m.timestamp, bm25(messages_fts) AS rank "
+                                               "FROM %1.messages_fts "
+                                               "JOIN %1.messages m ON m.id = messages_fts.rowid "
+                                               "JOIN main.users u ON u.id = m.sender_id "
+                                               "WHERE messages_fts MATCH :match AND m.chatgroup_id = :group_id "
+                                               "ORDER BY rank, m.id DESC LIMIT :limit OFFSET :offset").arg(schema));
+        StatementReset reset(query);
+        query.bindValue(":match", match);
+        query.bindValue(":group_id", groupId);
+        query.bindValue(":limit", tierLimit);
+        query.bindValue(":offset", tierOffset);
+
+        if (!query.exec()) {
+            qDebug() << "Failed to search group messages:" << query.lastError().text();
+            return QList<SearchHit>();
+        }
+        return readSearchHits(query);
+    });
+    probe.setRows(hits.size());
+    return hits;
+}
+
+QList<ChatDatabaseHandler::InboxEntry> ChatDatabaseHandler::getInbox(const QString &userEmail, int limit)
+{
+    static QueryHistogram &histogram = QueryStats::histogram("getInbox");
+    OperationProbe probe(this, histogram);
+
+    QList<InboxEntry> inbox;
+    int userId;
+    if (!dbInitialized || !lookupUser(userEmail, &userId)) {
+        return inbox;
+    }
+
+    // Each branch of the union is an index lookup; the outer query only
+    // touches the user's own conversations
+    QSqlQuery &query = cachedQuery("inbox",
+                                   "SELECT c.id, c.kind, c.chatgroup_id, g.name, peer.email, peer.name, "
+                                   "c.last_message_id, c.last_timestamp, m.content, "
+                                   "MAX(c.message_count - COALESCE(r.read_count, 0), 0) "
+                                   "FROM ("
+                                   "SELECT id FROM conversations WHERE user_low = :user1 "
+                                   "UNION SELECT id FROM conversations WHERE user_high = :user2 "
+                                   "UNION SELECT c2.id FROM user_chat_groups ucg "
+                                   "JOIN conversations c2 ON c2.chatgroup_id = ucg.chatgroup_id "
+                                   "WHERE ucg.user_id = :user3"
+                                   ") mine "
+                                   "JOIN conversations c ON c.id = mine.id "
+                                   "LEFT JOIN chat_groups g ON g.id = c.chatgroup_id "
+                                   "LEFT JOIN users peer ON peer.id = "
+                                   "CASE WHEN c.user_low = :user4 THEN c.user_high ELSE c.user_low END "
+                                   "LEFT JOIN messages m ON m.id = c.last_message_id "
+                                   "LEFT JOIN conversation_reads r ON r.conversation_id = c.id AND r.user_id = :user5 "
+                                   "ORDER BY c.last_timestamp DESC, c.id DESC LIMIT :limit");
+    StatementReset reset(query);
+    query.bindValue(":user1", userId);
+    query.bindValue(":user2", userId);
+    query.bindValue(":user3", userId);
+    query.bindValue(":user4", userId);
+    query.bindValue(":user5", userId);
+    query.bindValue(":limit", limit);
+
+    if (!query.exec()) {
+        qDebug() << "Failed to load inbox:" << query.lastError().text();
+        return inbox;
+    }
+
+    QList<int> archivedPreviews;
+    while (query.next()) {
+        InboxEntry entry;
+        entry.conversationId = query.value(0).toLongLong();
+        entry.isGroup = query.value(1).toString() == "group";
+        entry.chatId = entry.isGroup ? query.value(2).toString() : query.value(4).toString();
+        entry.title = entry.isGroup ? query.value(3).toString() : query.value(5).toString();
+        entry.lastMessageId = query.value(6).toLongLong();
+        entry.lastTimestamp = fromStoredTimestamp(query.value(7));
+        entry.lastMessage = decodeContent(query.value(8));
+        entry.unreadCount = query.value(9).toInt();
+        if (entry.lastMessageId > 0 && query.value(8).isNull()) {
+            archivedPreviews.append(inbox.size());
+        }
+        inbox.append(entry);
+    }
+    query.finish();
+
+    // Conversations that went quiet have their last message in an archive
+    if (!archivedPreviews.isEmpty()) {
+        const QList<ArchiveTier> tiers = archiveTiers();
+        for (int index : archivedPreviews) {
+            InboxEntry &entry = inbox[index];
+            for (const ArchiveTier &tier : tiers) {
+                if (entry.lastMessageId < tier.minId || entry.lastMessageId > tier.maxId) {
+                    continue;
+                }
+                QString schema = attachArchive(tier);
+                if (schema.isEmpty()) {
+                    break;
+                }
+                QSqlQuery &content = cachedQuery("archivedContent@" + schema,
+                                                 QString("SELECT content FROM %1.messages WHERE id = :id").arg(schema));
+                StatementReset contentReset(content);
+                content.bindValue(":id", entry.lastMessageId);
+                if (content.exec() && content.next()) {
+                    entry.lastMessage = decodeContent(content.value(0));
+                }
+                break;
+            }
+        }
+    }
+    probe.setRows(inbox.size());
+    return inbox;
+}
+
+bool ChatDatabaseHandler::markDirectConversationRead(const QString &userEmail, const QString &otherEmail)
+{
+    static QueryHistogram &histogram = QueryStats::histogram("markDirectConversationRead");
+    OperationProbe probe(this, histogram);
+
+    int userId, otherId;
+    if (!dbInitialized || !lookupUser(userEmail, &userId) || !lookupUser(otherEmail, &otherId)) {
+        return false;
+    }
+
+    QSqlQuery &query = cachedQuery("markDirectRead",
+                                   "INSERT INTO conversation_reads (conversation_id, user_id, last_read_message_id, read_count) "
+                                   "SELECT id, :user, last_message_id, message_count FROM conversations "
+                                   "WHERE user_low = :low AND user_high = :high "
+                                   "ON CONFLICT (conversation_id, user_id) DO UPDATE SET "
+                                   "last_read_message_id = excluded.last_read_message_id, read_count = excluded.read_count");
+    StatementReset reset(query);
+    query.bindValue(":user", userId);
+    query.bindValue(":low", qMin(userId, otherId));
+    query.bindValue(":high", qMax(userId, otherId));
+
+    if (!query.exec()) {
+        qDebug() << "Failed to update read cursor:" << query.lastError().text();
+        return false;
+    }
+    return true;
+}
+
+bool ChatDatabaseHandler::markGroupConversationRead(const QString &userEmail, const QString &groupName)
+{
+    return markGroupConversationRead(userEmail, lookupGroupId(groupName));
+}
+
+bool ChatDatabaseHandler::markGroupConversationRead(const QString &userEmail, int groupId)
+{
+    static QueryHistogram &histogram = QueryStats::histogram("markGroupConversationRead");
+    OperationProbe probe(this, histogram);
+
+    int userId;
+    if (!dbInitialized || groupId < 0 || !lookupUser(userEmail, &userId)) {
+        return false;
+    }
+
+    QSqlQuery &query = cachedQuery("markGroupRead",
+                                   "INSERT INTO conversation_reads (conversation_id, user_id, last_read_message_id, read_count) "
+                                   "SELECT id, :user, last_message_id, message_count FROM conversations "
+                                   "WHERE chatgroup_id = :group_id "
+                                   "ON CONFLICT (conversation_id, user_id) DO UPDATE SET "
+                                   "last_read_message_id = excluded.last_read_message_id, read_count = excluded.read_count");
+    StatementReset reset(query);
+    query.bindValue(":user", userId);
+    query.bindValue(":group_id", groupId);
+
+    if (!query.exec()) {
+        qDebug() << "Failed to update read cursor:" << query.lastError().text();
+        return false;
+    }
+    return true;
+}
+
+// Using std::tuple
+QList<std::tuple<QString, QString, QString, QDateTime>> ChatDatabaseHandler::getDirectMessageHistory(const QString &user1, const QString &user2, int limit)
+{
+    QList<std::tuple<QString, QString, QString, QDateTime>> messages;
+
+    // Newest page, already in chronological order
+    const MessageBatch batch = getDirectMessageBatch(user1, user2, 0, PageDirection::Before, limit);
+    for (const Message &message : batch.messages) {
+        const MessageSender &sender = batch.sender(message);
+        messages.append(std::make_tuple(sender.name, sender.email, message.content, message.dateTime()));
+    }
+
+    return messages;
+}
+
+
+QList<std::tuple<QString, QString, QString, QDateTime, QString>> ChatDatabaseHandler::getGroupMessageHistory(const QString &groupName, int limit)
+{
+    return getGroupMessageHistory(lookupGroupId(groupName), limit);
+}
+
+QList<std::tuple<QString, QString, QString, QDateTime, QString>> ChatDatabaseHandler::getGroupMessageHistory(int groupId, int limit)
+{
+    QList<std::tuple<QString, QString, QString, QDateTime, QString>> messages;
+
+    // Newest page, already in chronological order
+    const MessageBatch batch = getGroupMessageBatch(groupId, 0, PageDirection::Before, limit);
+    for (const Message &message : batch.messages) {
+        const MessageSender &sender = batch.sender(message);
+        messages.append(std::make_tuple(sender.name, sender.email, message.content,
+                                        message.dateTime(), messageTypeName(message.type)));
+    }
+
+    return messages;
+}
+
+bool ChatDatabaseHandler::isGroupMember(const QString &email, const QString &groupName)
+{
+    return isGroupMember(email, lookupGroupId(groupName));
+}
+
+bool ChatDatabaseHandler::isGroupMember(const QString &email, int groupId)
+{
+    static QueryHistogram &histogram = QueryStats::histogram("isGroupMember");
+    OperationProbe probe(this, histogram);
+
+    int userId;
+    if (!dbInitialized || groupId < 0 || !lookupUser(email, &userId)) {
+        return false;
+    }
+
+    // Primary key seek on (user_id, chatgroup_id)
+    QSqlQuery &query = cachedQuery("membershipExists",
+                                   "SELECT user_id FROM user_chat_groups WHERE user_id = :user_id AND chatgroup_id = :group_id");
+    StatementReset reset(query);
+    query.bindValue(":user_id", userId);
+    query.bindValue(":group_id", groupId);
+
+    return query.exec() && query.next();
+}
+
+bool ChatDatabaseHandler::removeUserFromGroup(const QString &email, const QString &groupName)
+{
+    return removeUserFromGroup(email, lookupGroupId(groupName));
+}
+
+bool ChatDatabaseHandler::removeUserFromGroup(const QString &email, int groupId)
+{
+    static QueryHistogram &histogram = QueryStats::histogram("removeUserFromGroup");
+    OperationProbe probe(this, histogram);
+
+    if (!dbInitialized || groupId < 0) {
+        return false; // Group not found
+    }
+
+    // First, get the user ID
+    int userId = -1;
+    if (!lookupUser(email, &userId)) {
+        return false; // User not found
+    }
+
+    // Membership and member count change together
+    if (!db.transaction()) {
+        qDebug() << "Failed to begin transaction:" << db.lastError().text();
+        return false;
+    }
+
+    // Now remove the user from the group
+    QSqlQuery &removeQuery = cachedQuery("deleteMembership",
+                                         "DELETE FROM user_chat_groups WHERE user_id = :userId AND chatgroup_id = :groupId");
+    StatementReset removeReset(removeQuery);
+    removeQuery.bindValue(":userId", userId);
+    removeQuery.bindValue(":groupId", groupId);
+
+    if (!removeQuery.exec()) {
+        db.rollback();
+        return false;
+    }
+
+    // Only count members that were actually there
+    if (removeQuery.numRowsAffected() > 0) {
+        QSqlQuery &countQuery = cachedQuery("decrementMemberCount",
+                                            "UPDATE chat_groups SET member_count = member_count - 1 WHERE id = :group_id");
+        StatementReset countReset(countQuery);
+        countQuery.bindValue(":group_id", groupId);
+
+        if (!countQuery.exec()) {
+            qDebug() << "Failed to update member count:" << countQuery.lastError().text();
+            db.rollback();
+            return false;
+        }
+    }
+
+    bool removed = removeQuery.numRowsAffected() > 0;
+    if (!db.commit()) {
+        return false;
+    }
+    if (removed) {
+        emit membershipChanged(groupId, email, false);
+    }
+    return true;
+}
+
+int ChatDatabaseHandler::checkGroupMemberCounts(bool repair)
+{
+    static QueryHistogram &histogram = QueryStats::histogram("checkGroupMemberCounts");
+    OperationProbe probe(this, histogram);
+
+    if (!dbInitialized) {
+        return -1;
+    }
+
+    // One grouped pass over the memberships, compared against every group
+    const QString actualCounts =
+        "SELECT g.id, g.name, g.member_count, COALESCE(m.members, 0) AS members FROM chat_groups g "
+        "LEFT JOIN (SELECT chatgroup_id, COUNT(*) AS members FROM user_chat_groups GROUP BY chatgroup_id) m "
+        "ON m.chatgroup_id = g.id ";
+
+    QSqlQuery check(db);
+    if (!check.exec(actualCounts + "WHERE g.member_count <> COALESCE(m.members, 0)")) {
+        qDebug() << "Failed to check member counts:" << check.lastError().text();
+        return -1;
+    }
+
+    int mismatched = 0;
+    while (check.next()) {
+        qDebug() << "Group" << check.value(0).toInt() << check.value(1).toString()
+                 << "has member_count" << check.value(2).toInt() << "but" << check.value(3).toInt() << "members";
+        ++mismatched;
+    }
+    check.finish();
+
+    if (repair && mismatched > 0) {
+        QSqlQuery rebuild(db);
+        if (!rebuild.exec("UPDATE chat_groups SET member_count = "
+                          "(SELECT COUNT(*) FROM user_chat_groups ucg WHERE ucg.chatgroup_id = chat_groups.id) "
+                          "WHERE member_count <> "
+                          "(SELECT COUNT(*) FROM user_chat_groups ucg WHERE ucg.chatgroup_id = chat_groups.id)")) {
+            qDebug() << "Failed to rebuild member counts:" << rebuild.lastError().text();
+            return -1;
+        }
+        qDebug() << "Rebuilt member counts for" << rebuild.numRowsAffected() << "groups";
+    }
+
+    return mismatched;
+}
+
+QList<std::tuple<QString, QString, int>> ChatDatabaseHandler::getGroupDetails(const QString &userEmail) const
+{
+    static QueryHistogram &histogram = QueryStats::histogram("getGroupDetails");
+    OperationProbe probe(this, histogram);
+
+    QList<std::tuple<QString, QString, int>> groups;
+
+    if (!dbInitialized) {
+        return groups;
+    }
+
+    QSqlQuery &query = cachedQuery("groupDetails",
+        "SELECT g.id, g.name, g.member_count "
+        "FROM chat_groups g "
+        "JOIN user_chat_groups ug ON g.id = ug.chatgroup_id "
+        "JOIN users u ON u.id = ug.user_id "
+        "WHERE u.email = :userEmail "
+        "ORDER BY g.name"
+    );
+    StatementReset reset(query);
+    query.bindValue(":userEmail", userEmail);
+
+    if (query.exec()) {
+        while (query.next()) {
+            groups.append(std::make_tuple(
+                query.value(0).toString(),  // group id
+                query.value(1).toString(),  // group name
+                query.value(2).toInt()      // member count
+            ));
+        }
+    }
+
+    probe.setRows(groups.size());
+    return groups;
+}
+
+QList<std::tuple<QString, QString, int>> ChatDatabaseHandler::getCreatedGroups(const QString &userEmail) const
+{
+    static QueryHistogram &histogram = QueryStats::histogram("getCreatedGroups");
+    OperationProbe probe(this, histogram);
+
+    QList<std::tuple<QString, QString, int>> groups;
+    if (!dbInitialized) {
+        return groups;
+    }
+
+    int userId;
+    if (!lookupUser(userEmail, &userId)) {
+        return groups;
+    }
+
+    QSqlQuery &query = cachedQuery("createdGroups",
+        "SELECT cg.id, cg.name, cg.member_count "
+        "FROM chat_groups cg "
+        "WHERE cg.created_by = :user_id "
+        "ORDER BY cg.name"
+    );
+    StatementReset reset(query);
+    query.bindValue(":user_id", userId);
+
+    if (query.exec()) {
+        while (query.next()) {
+            groups.append(std::make_tuple(
+                query.value(0).toString(),
+                query.value(1).toString(),
+                query.value(2).toInt()
+            ));
+        }
+        // qDebug() << "Created groups for" << userEmail << ":" << groups.size() << "groups found";
+    } else {
+        qDebug() << "Error in getCreatedGroups:" << query.lastError().text();
+        qDebug() << "Query:" << query.lastQuery();
+    }
+
+    probe.setRows(groups.size());
+    return groups;
+}
+
+QList<std::tuple<QString, QString, int>> ChatDatabaseHandler::getJoinedGroups(const QString &userEmail) const
+{
+    static QueryHistogram &histogram = QueryStats::histogram("getJoinedGroups");
+    OperationProbe probe(this, histogram);
+
+    QList<std::tuple<QString, QString, int>> groups;
+    if (!dbInitialized) {
+        return groups;
+    }
+
+    // Get user ID first
+    int userId;
+    if (!lookupUser(userEmail, &userId)) {
+        qDebug() << "Error getting user ID for" << userEmail;
+        return groups;
+    }
+
+    QSqlQuery &query = cachedQuery("joinedGroups",
+        "SELECT cg.id, cg.name, cg.member_count "
+        "FROM chat_groups cg "
+        "INNER JOIN user_chat_groups ucg1 ON cg.id = ucg1.chatgroup_id AND ucg1.user_id = :user_id "
+        "WHERE cg.created_by != :user_id "
+        "ORDER BY cg.name"
+    );
+    StatementReset reset(query);
+    query.bindValue(":user_id", userId);
+
+    if (query.exec()) {
+        while (query.next()) {
+            groups.append(std::make_tuple(
+                query.value(0).toString(),
+                query.value(1).toString(),
+                query.value(2).toInt()
+            ));
+        }
+    } else {
+        qDebug() << "Error in getJoinedGroups:" << query.lastError().text();
+        qDebug() << "Query:" << query.lastQuery();
+    }
+
+    probe.setRows(groups.size());
+    return groups;
+}
+
+QPair<QString, QString> ChatDatabaseHandler::getGroupAdmin(const QString &groupId) {
+    static QueryHistogram &histogram = QueryStats::histogram("getGroupAdmin");
+    OperationProbe probe(this, histogram);
+
+    QString name;
+    QString email;
+
+    if (!dbInitialized) {
+        return QPair<QString, QString>(name, email);
+    }
+
+    QSqlQuery &query = cachedQuery("groupAdmin",
+        "SELECT u.name, u.email FROM users u "
+        "JOIN chat_groups cg ON u.id = cg.created_by "
+        "WHERE cg.id = :groupId"
+        );
+    StatementReset reset(query);
+    query.bindValue(":groupId", groupId);
+
+    if (query.exec()) {
+        if (query.next()) {  // Move to the first (and only) result row
+            name = query.value(0).toString();
+            email = query.value(1).toString();
+        } else {
+            qDebug() << "Admin not found for group:" << groupId;
+        }
+    } else {
+        qDebug() << "SQL Error:" << query.lastError().text();
+    }
+
+    return QPair<QString, QString>(name, email);
+}
+
+bool ChatDatabaseHandler::updateGroupName(const QString &oldName, const QString &newName)
+{
+    static QueryHistogram &histogram = QueryStats::histogram("updateGroupNameByName");
+    OperationProbe probe(this, histogram);
+
+    if (!dbInitialized) return false;
+
+    QSqlQuery &query = cachedQuery("renameGroupByName",
+                                   "UPDATE chat_groups SET name = :newName WHERE name = :oldName");
+    StatementReset reset(query);
+    query.bindValue(":newName", newName);
+    query.bindValue(":oldName", oldName);
+
+    if (!query.exec()) {
+        qDebug() << "Failed to update group name:" << query.lastError().text();
+        return false;
+    }
+
+    if (query.numRowsAffected() <= 0) {
+        return false;
+    }
+    query.finish();
+    int groupId = lookupGroupId(newName);
+    notifyCommitted([this, groupId, newName]() {
+        emit groupRenamed(groupId, newName);
+    });
+    return true;
+}
+
+bool ChatDatabaseHandler::updateGroupName(int groupId, const QString &newName)
+{
+    static QueryHistogram &histogram = QueryStats::histogram("updateGroupName");
+    OperationProbe probe(this, histogram);
+
+    if (!dbInitialized) return false;
+
+    QSqlQuery &query = cachedQuery("renameGroup",
+                                   "UPDATE chat_groups SET name = :newName WHERE id = :group_id");
+    StatementReset reset(query);
+    query.bindValue(":newName", newName);
+    query.bindValue(":group_id", groupId);
+
+    if (!query.exec()) {
+        qDebug() << "Failed to update group name:" << query.lastError().text();
+        return false;
+    }
+
+    if (query.numRowsAffected() <= 0) {
+        return false;
+    }
+    notifyCommitted([this, groupId, newName]() {
+        emit groupRenamed(groupId, newName);
+    });
+    return true;
+}
+
+bool ChatDatabaseHandler::deleteGroup(const QString &groupId)
+{
+    static QueryHistogram &histogram = QueryStats::histogram("deleteGroup");
+    OperationProbe probe(this, histogram);
+
+    if (!dbInitialized) {
+        return false;
+    }
+
+    if (!db.transaction()) {
+        qDebug() << "Failed to begin transaction:" << db.lastError().text();
+        return false;
+    }
+
+    // Delete group messages
+    QSqlQuery &deleteMessages = cachedQuery("deleteGroupMessages",
+                                            "DELETE FROM messages WHERE chatgroup_id = :groupId");
+    StatementReset deleteMessagesReset(deleteMessages);
+    deleteMessages.bindValue(":groupId", groupId);
+    if (!deleteMessages.exec()) {
+        db.rollback();
+        qDebug() << "Failed to delete group messages:" << deleteMessages.lastError();
+        return false;
+    }
+
+    // Delete group memberships
+    QSqlQuery &deleteMembers = cachedQuery("deleteGroupMembers",
+                                           "DELETE FROM user_chat_groups WHERE chatgroup_id = :groupId");
+    StatementReset deleteMembersReset(deleteMembers);
+    deleteMembers.bindValue(":groupId", groupId);
+    if (!deleteMembers.exec()) {
+        db.rollback();
+        qDebug() << "Failed to delete group members:" << deleteMembers.lastError();
+        return false;
+    }
+
+    // Delete the group itself, its member_count goes with it
+    QSqlQuery &deleteGroup = cachedQuery("deleteGroup", "DELETE FROM chat_groups WHERE id = :groupId");
+    StatementReset deleteGroupReset(deleteGroup);
+    deleteGroup.bindValue(":groupId", groupId);
+    if (!deleteGroup.exec()) {
+        db.rollback();
+        qDebug() << "Failed to delete group:" << deleteGroup.lastError();
+        return false;
+    }
+
+    // A missing or malformed id deletes nothing and must not be announced
+    if (deleteGroup.numRowsAffected() != 1) {
+        db.rollback();
+        qDebug() << "Group" << groupId << "not found";
+        return false;
+    }
+
+    if (!db.commit()) {
+        return false;
+    }
+    emit groupDeleted(groupId.toInt());
+
+    // Archived history goes too. ATTACH can't run inside the transaction
+    // above, so each archive is cleaned up on its own afterwards.
+    for (const ArchiveTier &tier : archiveTiers()) {
+        QString schema = attachArchive(tier);
+        if (schema.isEmpty()) {
+            continue;
+        }
+
+        QSqlQuery deleteIndexed(db);
+        deleteIndexed.prepare(QString("DELETE FROM %1.messages_fts WHERE rowid IN "
+                                      "(SELECT id FROM %1.messages WHERE chatgroup_id = :groupId)").arg(schema));
+        deleteIndexed.bindValue(":groupId", groupId);
+        QSqlQuery deleteArchived(db);
+        deleteArchived.prepare(QString("DELETE FROM %1.messages WHERE chatgroup_id = :groupId").arg(schema));
+        deleteArchived.bindValue(":groupId", groupId);
+        if (!deleteIndexed.exec() || !deleteArchived.exec()) {
+            qDebug() << "Failed to delete archived group messages:" << deleteIndexed.lastError() << deleteArchived.lastError();
+        }
+    }
+    return true;
+}
@@ -1,66 +1,270 @@
-// chatdbhandler.h
-#ifndef CHATDBHANDLER_H
-#define CHATDBHANDLER_H
-
-#include <QObject>
-#include <QSqlDatabase>
-#include <QSqlQuery>
-#include <QSqlError>
-#include <QString>
-#include <QStringList>
-#include <QMap>
-#include <QPair>
-#include <QDateTime>
-#include <QDebug>
-#include <tuple>
-
-class ChatDatabaseHandler : public QObject
-{
-    Q_OBJECT
-
-public:
-    explicit ChatDatabaseHandler(QObject *parent = nullptr);
-    ~ChatDatabaseHandler();
-
-    // Database setup
-    bool initialize();
-
-    // User operations
-    QString loginUser(const QString &email, const QString &password);
-    bool registerUser(const QString &username, const QString &email, const QString &password);
-    QString userExists(const QString & email);
-
-    // Chat group operations
-    int createGroupChat(const QString &name, const QString &creatorEmail);
-    bool joinGroupChat(const QString &userEmail, const QString &groupId);
-    QList<std::tuple<QString, QString, int>> getCreatedGroups(const QString &userEmail) const;  // Returns (id, name, member_count) for groups created by user
-    QList<std::tuple<QString, QString, int>> getJoinedGroups(const QString &userEmail) const;  // Returns (id, name, member_count) for groups joined by user
-    QStringList getUserGroups(const QString &userEmail) const;
-    QList<std::tuple<QString, QString, int>> getGroupDetails(const QString &userEmail) const;  // Returns (id, name, member_count)
-    QString groupChatExists(const QString & chatId);
-    QList<QPair<QString, QString>> getGroupChatMembers(const QString &chatName);
-    bool removeUserFromGroup(const QString &email, const QString &groupName);
-    QPair<QString, QString> getGroupAdmin(const QString &groupId);
-    bool updateGroupName(const QString &oldName, const QString &newName);
-    bool deleteGroup(const QString &groupId);
-    bool isGroupMember(const QString &email, const QString &groupName);
-
-    // Message operations
-    bool sendDirectMessage(const QString &sender, const QString &recipient, const QString &content);
-    bool sendGroupMessage(const QString &sender, const QString &groupName, const QString &content, const QString &type = "text");
-
-    // Using std::tuple<sender_name, sender_email, content, timestamp>
-    QList<std::tuple<QString, QString, QString, QDateTime>> getDirectMessageHistory(const QString &user1, const QString &user2, int limit);
-    QList<std::tuple<QString, QString, QString, QDateTime, QString>> getGroupMessageHistory(const QString &groupName, int limit);
-
-
-
-private:
-    QSqlDatabase db;
-    bool dbInitialized;
-
-    bool executeQuery(const QString &sql);
-    bool checkTableExists(const QString &tableName);
-};
-
-#endif // CHATDBHANDLER_H
+// chatdbhandler.h
+#ifndef CHATDBHANDLER_H
+#define CHATDBHANDLER_H
+
+#include <QObject>
+#include <QSqlDatabase>
+#include <QSqlQuery>
+#include <QSqlError>
+#include <QString>
+#include <QStringList>
+#include <QMap>
+#include <QPair>
+#include <QHash>
+#include <QCache>
+#include <QDateTime>
+#include <QDebug>
+#include <tuple>
+#include <functional>
+
+#include "connectionprofile.h"
+#include "chatmessage.h"
+#include "messagearchive.h"
+#include "messagecodec.h"
+#include "querystats.h"
+
+class ChatDatabaseHandler : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit ChatDatabaseHandler(QObject *parent = nullptr);
+    ~ChatDatabaseHandler();
+
+    // Database setup
+    bool initialize();
+    void setConnectionProfile(const ConnectionProfile &profile) { connectionProfile = profile; }
+    // Connection used by this handler; each thread needs its own
+    void setConnectionName(const QString &name) { connectionName = name; }
+    // Database file, chat_database.db in the working directory by default
+    void setDatabaseName(const QString &name) { databaseName = name; }
+    // Read-only handlers skip schema setup and reject writes
+    void setReadOnly(bool enabled) { readOnly = enabled; }
+    const ConnectionProfile &profile() const { return connectionProfile; }
+
+    // User operations
+    QString loginUser(const QString &email, const QString &password);
+    bool registerUser(const QString &username, const QString &email, const QString &password);
+    QString userExists(const QString & email);
+
+    // Chat group operations
+    int createGroupChat(const QString &name, const QString &creatorEmail);
+    bool joinGroupChat(const QString &userEmail, const QString &groupId);
+    QList<std::tuple<QString, QString, int>> getCreatedGroups(const QString &userEmail) const;  // Returns (id, name, member_count) for groups created by user
+    QList<std::tuple<QString, QString, int>> getJoinedGroups(const QString &userEmail) const;  // Returns (id, name, member_count) for groups joined by user
+    QStringList getUserGroups(const QString &userEmail) const;
+    QList<std::tuple<QString, QString, int>> getGroupDetails(const QString &userEmail) const;  // Returns (id, name, member_count)
+    QString groupChatExists(const QString & chatId);
+    QList<QPair<QString, QString>> getGroupChatMembers(const QString &chatName);
+    bool removeUserFromGroup(const QString &email, const QString &groupName);
+    QPair<QString, QString> getGroupAdmin(const QString &groupId);
+    bool updateGroupName(const QString &oldName, const QString &newName);
+    bool deleteGroup(const QString &groupId);
+    bool isGroupMember(const QString &email, const QString &groupName);
+
+    // Same operations keyed by group id, which skip the lookup by name
+    QList<QPair<QString, QString>> getGroupChatMembers(int groupId);
+    bool removeUserFromGroup(const QString &email, int groupId);
+    bool updateGroupName(int groupId, const QString &newName);
+    bool isGroupMember(const QString &email, int groupId);
+
+    // Moves messages older than `days` into the monthly archive files next
+    // to the database. History, search and the inbox read through to the
+    // archives. Returns the number of messages moved, or -1 on error.
+    qint64 archiveOldMessages(int days);
+
+    // Compares chat_groups.member_count with the membership table. Returns
+    // the number of groups that were off (and fixed, if repair is set), or
+    // -1 on error.
+    int checkGroupMemberCounts(bool repair);
+
+    // Message operations
+    bool sendDirectMessage(const QString &sender, const QString &recipient, const QString &content);
+    bool sendGroupMessage(const QString &sender, const QString &groupName, const QString &content, const QString &type = "text");
+    // Same inserts, returning the new message id or -1 on failure
+    qint64 insertDirectMessage(const QString &sender, const QString &recipient, const QString &content);
+    qint64 insertGroupMessage(const QString &sender, const QString &groupName, const QString &content, const QString &type = "text");
+    qint64 insertGroupMessage(const QString &sender, int groupId, const QString &content, const QString &type = "text");
+
+    // Trains a shared compression dictionary on recent large messages and
+    // uses it for bodies written from now on. Returns its id, or -1 if
+    // there is too little repeated content (or no zlib support).
+    int trainCompressionDictionary(int sampleCount = 2000);
+    int compressionDictionaryId() const { return codec.activeDictionaryId(); }
+
+    // Compressed bodies in the main database: how much they take up, how
+    // much the text would, and how long decoding all of them took
+    struct CompressionReport {
+        qint64 compressedRows;
+        qint64 storedBytes;
+        qint64 plainBytes;
+        qint64 decodeNsecs;
+    };
+    CompressionReport compressionReport() const;
+
+    // Looks for commits made through other connections to the same file,
+    // e.g. another QuickChat process; costs one PRAGMA when there are none.
+    // New messages are announced through messageInserted, the newest one of
+    // each conversation, and group or membership changes through
+    // groupsChangedExternally. Returns true if anything was committed.
+    bool checkExternalChanges();
+
+    // Explicit transactions, used to commit several writes at once
+    bool beginTransaction();
+    bool commitTransaction();
+    void rollbackTransaction();
+
+    // Newest page as tuples, read through the batch path
+    // Using std::tuple<sender_name, sender_email, content, timestamp>
+    QList<std::tuple<QString, QString, QString, QDateTime>> getDirectMessageHistory(const QString &user1, const QString &user2, int limit);
+    QList<std::tuple<QString, QString, QString, QDateTime, QString>> getGroupMessageHistory(const QString &groupName, int limit);
+    QList<std::tuple<QString, QString, QString, QDateTime, QString>> getGroupMessageHistory(int groupId, int limit);
+
+    // Keyset pagination over message ids. Returns up to `limit` messages before
+    // or after anchorId, oldest first, as compact records: integer type and
+    // timestamp, with each sender loaded once per batch instead of once per
+    // row. Before with anchorId <= 0 is the newest page.
+    enum class PageDirection { Before, After };
+    MessageBatch getDirectMessageBatch(const QString &user1, const QString &user2,
+                                       qint64 anchorId, PageDirection direction, int limit);
+    MessageBatch getGroupMessageBatch(int groupId, qint64 anchorId, PageDirection direction, int limit);
+
+    // Full-text search, best matches first. The snippet is HTML escaped with
+    // matched terms in <b></b>. Pages are `limit` hits starting at `offset`.
+    // (message_id, sender_name, sender_email, snippet, timestamp, rank)
+    using SearchHit = std::tuple<qint64, QString, QString, QString, QDateTime, double>;
+    QList<SearchHit> searchDirectMessages(const QString &user1, const QString &user2, const QString &text,
+                                          int offset, int limit);
+    // Only returns hits if userEmail is a member of the group
+    QList<SearchHit> searchGroupMessages(const QString &userEmail, const QString &groupName, const QString &text,
+                                         int offset, int limit);
+    QList<SearchHit> searchGroupMessages(const QString &userEmail, int groupId, const QString &text,
+                                         int offset, int limit);
+
+    // Inbox: every direct conversation and joined group of a user, most
+    // recently active first, from the conversations summary table
+    struct InboxEntry {
+        qint64 conversationId;
+        bool isGroup;
+        QString chatId;         // group id, or the other user's email
+        QString title;          // group name, or the other user's name
+        qint64 lastMessageId;   // 0 when nothing was sent yet
+        QDateTime lastTimestamp;
+        QString lastMessage;
+        int unreadCount;
+    };
+    QList<InboxEntry> getInbox(const QString &userEmail, int limit = 100);
+
+    // Moves the user's read cursor to the newest message of the conversation
+    bool markDirectConversationRead(const QString &userEmail, const QString &otherEmail);
+    bool markGroupConversationRead(const QString &userEmail, const QString &groupName);
+    bool markGroupConversationRead(const QString &userEmail, int groupId);
+
+    // Prepared statement cache counters
+    quint64 statementCacheHits() const { return stmtCacheHits; }
+    quint64 statementCacheMisses() const { return stmtCacheMisses; }
+    int cachedStatementCount() const { return statementCache.size(); }
+
+    // User identity cache (email -> id, name); 0 means unbounded
+    void setUserCacheCapacity(int maxUsers);
+    int cachedUserCount() const { return userCache.size(); }
+
+signals:
+    // Emitted on the handler's thread once a write of this handler has
+    // committed; inside beginTransaction() that is at commitTransaction(),
+    // and nothing is emitted for a rolled back transaction.
+    // groupId is -1 for direct messages, recipientEmail empty for group ones.
+    void messageInserted(qint64 messageId, int groupId, const QString &senderEmail, const QString &recipientEmail);
+    void membershipChanged(int groupId, const QString &userEmail, bool joined);
+    void groupRenamed(int groupId, const QString &newName);
+    void groupDeleted(int groupId);
+    // Groups or memberships were changed by another connection, found by
+    // checkExternalChanges(); which ones isn't known
+    void groupsChangedExternally();
+
+private:
+    QSqlDatabase db;
+    QString connectionName;
+    QString databaseName;
+    bool readOnly;
+    bool dbInitialized;
+    ConnectionProfile connectionProfile;
+
+    // Long-lived prepared statements, keyed by statement id
+    mutable QHash<QString, QSqlQuery *> statementCache;
+    mutable quint64 stmtCacheHits;
+    mutable quint64 stmtCacheMisses;
+
+    // Identity of a user as loaded from the users table
+    struct CachedUser {
+        int id;
+        QString name;
+    };
+    mutable QCache<QString, CachedUser> userCache;
+
+    // conversations.id of each direct user pair (lower id first) seen so
+    // far. Direct conversations are never deleted, so entries stay valid;
+    // a rollback may undo new ones and clears the map.
+    mutable QHash<QPair<int, int>, qint64> directConversations;
+
+    // Notifications of writes made inside an explicit transaction, sent on commit
+    bool inTransaction;
+    QList<std::function<void()>> pendingNotifications;
+
+    // What checkExternalChanges() has seen so far; our own writes are not
+    // counted, so they may be announced a second time with the next
+    // external ones
+    qint64 seenDataVersion;     // -1 until the first check
+    qint64 seenMessageId;
+    qint64 seenGroupChanges;
+
+    // Public operations are timed into QueryStats histograms. The SQL of
+    // the cached statements they use is kept meanwhile, so an operation
+    // slower than the profile's slowQueryMs can be logged with its plans.
+    class OperationProbe;
+    mutable int probeDepth;
+    mutable QStringList probedStatements;
+    void explainSlowOperation(const char *name, qint64 nsecs, qint64 rows, int firstStatement) const;
+
+    // Compression of large message bodies; dictionaries load lazily
+    mutable MessageCodec codec;
+
+    // Archive files sit next to the database and are attached on demand
+    static const int maxAttachedArchives = 8;
+    QString archiveDirectory;
+    QStringList attachedArchives;   // schema names, least recently used first
+
+    QSqlQuery &cachedQuery(const QString &id, const QString &sql) const;
+    bool lookupUser(const QString &email, int *userId, QString *userName = nullptr) const;
+    int lookupGroupId(const QString &groupName) const;
+    qint64 lookupDirectConversation(int userId1, int userId2) const;
+    void notifyCommitted(std::function<void()> notification);
+    // Compressed bodies are indexed by hand; the row and its index entry
+    // are written under one savepoint, inside a batch or on their own
+    bool beginIndexedInsert();
+    bool endIndexedInsert(bool keep);
+    bool indexCompressedContent(qint64 messageId, const QString &content);
+    QString decodeContent(const QVariant &storedContent) const;
+    int readMessageBatch(QSqlQuery &query, MessageBatch &batch, qint64 *lastId) const;
+    void resolveSenders(MessageBatch &batch) const;
+
+    // Reads one page from the hot tables and the archive tiers in page
+    // order. fetch reads up to `limit` rows past anchorId from the messages
+    // table in `schema`, stores the last id it read and returns the count.
+    using TierFetch = std::function<int(const QString &schema, qint64 anchorId, int limit, qint64 *lastId)>;
+    void readTiered(qint64 anchorId, PageDirection direction, int limit, const TierFetch &fetch);
+    // Runs search(schema, offset, limit) on every tier and merges by rank
+    using TierSearch = std::function<QList<SearchHit>(const QString &schema, int offset, int limit)>;
+    QList<SearchHit> searchTiered(int offset, int limit, const TierSearch &search);
+    QList<ArchiveTier> archiveTiers() const;
+    QString attachArchive(const ArchiveTier &tier);
+    void detachArchive(const QString &schema);
+    QList<SearchHit> readSearchHits(QSqlQuery &query) const;
+    static QString snippetHtml(const QString &snippet);
+    void clearStatementCache();
+
+    bool executeQuery(const QString &sql);
+    bool checkTableExists(const QString &tableName);
+};
+
+#endif // CHATDBHANDLER_H
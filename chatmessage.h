@@ -0,0 +1,79 @@
+// chatmessage.h
+#ifndef CHATMESSAGE_H
+#define CHATMESSAGE_H
+
+#include <QString>
+#include <QDateTime>
+#include <QHash>
+#include <vector>
+
+#include "messagetime.h"
+
+// Kind of message, from messages.type ('message' and 'text' are both plain text)
+enum class MessageType : quint8 { Text, User, System };
+
+// SQL expression mapping messages.type to MessageType, so rows carry an
+// integer instead of a string
+inline QString messageTypeSql(const QString &column)
+{
+    return QString("CASE %1 WHEN 'user' THEN 1 WHEN 'system' THEN 2 ELSE 0 END").arg(column);
+}
+
+// messages.type value for a MessageType
+inline QString messageTypeName(MessageType type)
+{
+    switch (type) {
+    case MessageType::User:
+        return "user";
+    case MessageType::System:
+        return "system";
+    default:
+        return "text";
+    }
+}
+
+// Sender of one or more messages in a batch
+struct MessageSender {
+    int id;
+    QString name;
+    QString email;
+};
+
+// One message row. Sender details live once per batch in
+// MessageBatch::senders, the row only keeps an index into it.
+struct Message {
+    qint64 id;
+    qint64 timestamp;   // epoch milliseconds, see messagetime.h
+    QString content;
+    int sender;         // index into MessageBatch::senders
+    MessageType type;
+
+    QDateTime dateTime() const { return QDateTime::fromMSecsSinceEpoch(timestamp); }
+};
+
+// A page of messages, oldest first, with the senders it refers to
+struct MessageBatch {
+    std::vector<Message> messages;
+    std::vector<MessageSender> senders;
+
+    bool isEmpty() const { return messages.empty(); }
+    const MessageSender &sender(const Message &message) const { return senders[message.sender]; }
+
+    // Index of userId in senders, adding an unresolved entry on first use
+    int internSender(int userId)
+    {
+        auto it = senderIndex.constFind(userId);
+        if (it != senderIndex.constEnd()) {
+            return it.value();
+        }
+        int index = int(senders.size());
+        senders.push_back(MessageSender{userId, QString(), QString()});
+        senderIndex.insert(userId, index);
+        return index;
+    }
+
+private:
+    QHash<int, int> senderIndex;   // user id -> index in senders
+};
+
+#endif // CHATMESSAGE_H
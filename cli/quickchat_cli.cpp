@@ -0,0 +1,168 @@
+// quickchat_cli.cpp
+//
+// Drives the data layer without the GUI, for scripting, staging setups
+// and profiling:
+//
+//     quickchat_cli [--database file] [--stats] <command> [arguments]
+//
+//     init                          create and seed the demo database
+//     load <records.jsonl|.csv>     bulk-load a new database (see setup_db.h)
+//     migrate                       bring the schema up to date
+//     groups <email>                groups the user created or joined
+//     history <group id> [limit]    newest messages of a group
+//     dm <email> <email> [limit]    newest direct messages between two users
+//     send <email> <group id> <text...>
+//     archive <days>                move older messages to the archive files
+//     check-counts [repair]         compare member counts with the memberships
+//
+// --stats prints the latency of each data layer operation afterwards.
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QTextStream>
+
+#include "../setup_db.h"
+#include "../chatdbhandler.h"
+#include "../querystats.h"
+
+namespace {
+
+QTextStream &out()
+{
+    static QTextStream stream(stdout);
+    return stream;
+}
+
+void printBatch(const MessageBatch &batch)
+{
+    for (const Message &message : batch.messages) {
+        out() << message.id << '\t'
+              << message.dateTime().toString("yyyy-MM-dd hh:mm:ss") << '\t'
+              << batch.sender(message).name << '\t'
+              << message.content << '\n';
+    }
+}
+
+void printStats()
+{
+    out() << "operation\tcalls\tp50_ms\tp95_ms\tp99_ms\tmax_ms\trows\n";
+    for (const QueryStats::Operation &operation : QueryStats::snapshot()) {
+        out() << operation.name << '\t' << operation.calls << '\t'
+              << operation.p50Nsecs / 1e6 << '\t' << operation.p95Nsecs / 1e6 << '\t'
+              << operation.p99Nsecs / 1e6 << '\t' << operation.maxNsecs / 1e6 << '\t'
+              << operation.rows << '\n';
+    }
+}
+
+int usage(const QCommandLineParser &parser)
+{
+    out() << parser.helpText();
+    return 2;
+}
+
+// Runs a command on an open database; -1 if the arguments don't fit it
+int runCommand(ChatDatabaseHandler &handler, const QStringList &args)
+{
+    const QString &command = args.first();
+    if (command == "migrate") {
+        return 0;   // initialize() has run the migrations
+    }
+    if (command == "groups" && args.size() == 2) {
+        const auto created = handler.getCreatedGroups(args[1]);
+        const auto joined = handler.getJoinedGroups(args[1]);
+        for (const auto &group : created) {
+            out() << std::get<0>(group) << '\t' << std::get<1>(group) << '\t' << std::get<2>(group) << "\tcreated\n";
+        }
+        for (const auto &group : joined) {
+            out() << std::get<0>(group) << '\t' << std::get<1>(group) << '\t' << std::get<2>(group) << "\tjoined\n";
+        }
+        return 0;
+    }
+    if (command == "history" && (args.size() == 2 || args.size() == 3)) {
+        int limit = args.size() == 3 ? args[2].toInt() : 50;
+        printBatch(handler.getGroupMessageBatch(args[1].toInt(), 0, ChatDatabaseHandler::PageDirection::Before, limit));
+        return 0;
+    }
+    if (command == "dm" && (args.size() == 3 || args.size() == 4)) {
+        int limit = args.size() == 4 ? args[3].toInt() : 50;
+        printBatch(handler.getDirectMessageBatch(args[1], args[2], 0, ChatDatabaseHandler::PageDirection::Before, limit));
+        return 0;
+    }
+    if (command == "send" && args.size() >= 4) {
+        qint64 id = handler.insertGroupMessage(args[1], args[2].toInt(), args.mid(3).join(' '));
+        if (id < 0) {
+            return 1;
+        }
+        out() << id << '\n';
+        return 0;
+    }
+    if (command == "archive" && args.size() == 2) {
+        qint64 moved = handler.archiveOldMessages(args[1].toInt());
+        if (moved < 0) {
+            return 1;
+        }
+        out() << moved << " messages archived\n";
+        return 0;
+    }
+    if (command == "check-counts" && args.size() <= 2) {
+        int wrong = handler.checkGroupMemberCounts(args.size() == 2 && args[1] == "repair");
+        if (wrong < 0) {
+            return 1;
+        }
+        out() << wrong << " groups with a wrong member count\n";
+        return 0;
+    }
+    return -1;
+}
+
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription(
+        "Runs QuickChat database operations without the GUI.\n\n"
+        "Commands: init, load <file>, migrate, groups <email>, history <group id> [limit],\n"
+        "dm <email> <email> [limit], send <email> <group id> <text>, archive <days>,\n"
+        "check-counts [repair]");
+    parser.addHelpOption();
+    QCommandLineOption databaseOption("database", "Database file.", "file", "chat_database.db");
+    QCommandLineOption statsOption("stats", "Print the latency of each database operation afterwards.");
+    parser.addOptions({databaseOption, statsOption});
+    parser.addPositionalArgument("command", "Operation to run.");
+    parser.process(app);
+
+    const QStringList args = parser.positionalArguments();
+    if (args.isEmpty()) {
+        return usage(parser);
+    }
+    const QString command = args.first();
+    const QString database = parser.value(databaseOption);
+
+    // Commands that create the database file
+    if (command == "init") {
+        return setup_chat_db(database);
+    }
+    if (command == "load") {
+        return args.size() == 2 ? bulk_load_chat_db(args[1], database) : usage(parser);
+    }
+
+    if (!checkDatabaseExists(database)) {
+        qDebug() << "No database at" << database << "- run init or load first";
+        return 1;
+    }
+
+    ChatDatabaseHandler handler;
+    handler.setConnectionName("quickchat_cli");
+    handler.setDatabaseName(database);
+    if (!handler.initialize()) {
+        return 1;
+    }
+
+    int result = runCommand(handler, args);
+    if (parser.isSet(statsOption)) {
+        printStats();
+    }
+    return result < 0 ? usage(parser) : result;
+}
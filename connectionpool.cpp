@@ -0,0 +1,32 @@
+#include "connectionpool.h"
+
+ChatConnectionPool::ChatConnectionPool(int readerCount)
+    : nextReaderId(0)
+{
+    threadPool.setObjectName("QuickChat readers");
+    threadPool.setMaxThreadCount(qMax(1, readerCount));
+
+    // Keep threads, and with them their open connections, alive while idle
+    threadPool.setExpiryTimeout(-1);
+}
+
+ChatConnectionPool::~ChatConnectionPool()
+{
+    threadPool.waitForDone();
+}
+
+ChatDatabaseHandler *ChatConnectionPool::readerForCurrentThread()
+{
+    if (!readers.hasLocalData()) {
+        ChatDatabaseHandler *reader = new ChatDatabaseHandler();
+        reader->setConnectionName(QString("quickchat_reader_%1").arg(nextReaderId.fetchAndAddRelaxed(1)));
+        reader->setReadOnly(true);
+        readers.setLocalData(reader); // deleted when the thread exits
+    }
+
+    ChatDatabaseHandler *reader = readers.localData();
+    if (!reader->initialize()) {
+        qDebug() << "Failed to open reader connection";
+    }
+    return reader;
+}
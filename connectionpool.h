@@ -0,0 +1,34 @@
+#ifndef CONNECTIONPOOL_H
+#define CONNECTIONPOOL_H
+
+#include <QThreadPool>
+#include <QThreadStorage>
+#include <QAtomicInt>
+
+#include "chatdbhandler.h"
+
+// Read-only connections for concurrent queries. Each thread of the
+// pool's own QThreadPool gets a named connection (and its own handler
+// with its own statement cache) the first time it runs a read. Under
+// WAL these readers never block the writer or each other.
+class ChatConnectionPool
+{
+public:
+    explicit ChatConnectionPool(int readerCount);
+    ~ChatConnectionPool();
+
+    QThreadPool *readerThreads() { return &threadPool; }
+    int readerCount() const { return threadPool.maxThreadCount(); }
+
+    // Handler bound to the calling pool thread's reader connection
+    ChatDatabaseHandler *readerForCurrentThread();
+
+private:
+    // Declared before threadPool: the pool threads must exit (and
+    // delete their handlers) before the storage itself goes away
+    QThreadStorage<ChatDatabaseHandler *> readers;
+    QAtomicInt nextReaderId;
+    QThreadPool threadPool;
+};
+
+#endif // CONNECTIONPOOL_H
@@ -0,0 +1,193 @@
+#include "connectionprofile.h"
+
+#include <QSqlQuery>
+#include <QSqlError>
+#include <QSettings>
+#include <QFile>
+#include <QStringList>
+#include <QDebug>
+
+namespace {
+
+// Pragma values can't be bound as parameters, so only known keywords are accepted
+QString checkedKeyword(const QString &value, const QStringList &allowed, const QString &fallback)
+{
+    QString upper = value.trimmed().toUpper();
+    if (allowed.contains(upper)) {
+        return upper;
+    }
+    qDebug() << "Ignoring unsupported pragma value:" << value;
+    return fallback;
+}
+
+QString pragmaValue(QSqlDatabase &db, const QString &pragma)
+{
+    QSqlQuery query(db);
+    if (query.exec("PRAGMA " + pragma) && query.next()) {
+        return query.value(0).toString();
+    }
+    return QString();
+}
+
+}
+
+ConnectionProfile ConnectionProfile::durable()
+{
+    ConnectionProfile profile;
+    profile.name = "durable";
+    profile.journalMode = "WAL";
+    profile.synchronous = "FULL";
+    profile.cacheSize = -16000;         // ~16 MiB
+    profile.tempStore = "MEMORY";
+    profile.mmapSize = 64ll * 1024 * 1024;
+    profile.busyTimeout = 5000;
+    profile.readerConnections = 4;
+    profile.archiveAfterDays = 0;
+    profile.compressAbove = 0;
+    profile.compressionDictionary = false;
+    profile.changePollMin = 250;
+    profile.changePollMax = 8000;
+    profile.slowQueryMs = 200;
+    return profile;
+}
+
+ConnectionProfile ConnectionProfile::fast()
+{
+    ConnectionProfile profile;
+    profile.name = "fast";
+    profile.journalMode = "WAL";
+    profile.synchronous = "NORMAL";
+    profile.cacheSize = -64000;         // ~64 MiB
+    profile.tempStore = "MEMORY";
+    profile.mmapSize = 256ll * 1024 * 1024;
+    profile.busyTimeout = 5000;
+    profile.readerConnections = 4;
+    profile.archiveAfterDays = 0;
+    profile.compressAbove = 0;
+    profile.compressionDictionary = false;
+    profile.changePollMin = 250;
+    profile.changePollMax = 8000;
+    profile.slowQueryMs = 200;
+    return profile;
+}
+
+ConnectionProfile ConnectionProfile::fromConfig(const QString &path)
+{
+    if (!QFile::exists(path)) {
+        return durable();
+    }
+
+    QSettings settings(path, QSettings::IniFormat);
+    settings.beginGroup("database");
+
+    QString presetName = settings.value("profile", "durable").toString().trimmed().toLower();
+    ConnectionProfile profile = presetName == "fast" ? fast() : durable();
+    if (presetName != "fast" && presetName != "durable") {
+        qDebug() << "Unknown database profile" << presetName << "- using durable";
+    }
+
+    bool overridden = false;
+    if (settings.contains("journal_mode")) {
+        profile.journalMode = checkedKeyword(settings.value("journal_mode").toString(),
+                                             {"DELETE", "TRUNCATE", "PERSIST", "MEMORY", "WAL", "OFF"},
+                                             profile.journalMode);
+        overridden = true;
+    }
+    if (settings.contains("synchronous")) {
+        profile.synchronous = checkedKeyword(settings.value("synchronous").toString(),
+                                             {"OFF", "NORMAL", "FULL", "EXTRA"},
+                                             profile.synchronous);
+        overridden = true;
+    }
+    if (settings.contains("cache_size")) {
+        profile.cacheSize = settings.value("cache_size").toInt();
+        overridden = true;
+    }
+    if (settings.contains("temp_store")) {
+        profile.tempStore = checkedKeyword(settings.value("temp_store").toString(),
+                                           {"DEFAULT", "FILE", "MEMORY"},
+                                           profile.tempStore);
+        overridden = true;
+    }
+    if (settings.contains("mmap_size")) {
+        profile.mmapSize = settings.value("mmap_size").toLongLong();
+        overridden = true;
+    }
+    if (settings.contains("busy_timeout")) {
+        profile.busyTimeout = settings.value("busy_timeout").toInt();
+        overridden = true;
+    }
+    if (settings.contains("reader_connections")) {
+        profile.readerConnections = settings.value("reader_connections").toInt();
+        overridden = true;
+    }
+    if (settings.contains("archive_after_days")) {
+        profile.archiveAfterDays = settings.value("archive_after_days").toInt();
+        overridden = true;
+    }
+    if (settings.contains("compress_above")) {
+        profile.compressAbove = settings.value("compress_above").toInt();
+        overridden = true;
+    }
+    if (settings.contains("compression_dictionary")) {
+        profile.compressionDictionary = settings.value("compression_dictionary").toBool();
+        overridden = true;
+    }
+    if (settings.contains("change_poll_min")) {
+        profile.changePollMin = settings.value("change_poll_min").toInt();
+        overridden = true;
+    }
+    if (settings.contains("change_poll_max")) {
+        profile.changePollMax = settings.value("change_poll_max").toInt();
+        overridden = true;
+    }
+    if (settings.contains("slow_query_ms")) {
+        profile.slowQueryMs = settings.value("slow_query_ms").toInt();
+        overridden = true;
+    }
+
+    settings.endGroup();
+
+    if (overridden) {
+        profile.name += "+custom";
+    }
+    return profile;
+}
+
+bool ConnectionProfile::apply(QSqlDatabase &db, bool readOnly) const
+{
+    QStringList pragmas = {
+        // busy_timeout first so the journal mode switch can wait for other connections
+        QString("busy_timeout = %1").arg(busyTimeout),
+        QString("journal_mode = %1").arg(journalMode),
+        QString("synchronous = %1").arg(synchronous),
+        QString("cache_size = %1").arg(cacheSize),
+        QString("temp_store = %1").arg(tempStore),
+        QString("mmap_size = %1").arg(mmapSize),
+    };
+    if (readOnly) {
+        pragmas.removeAt(1);
+    }
+
+    bool ok = true;
+    for (const QString &pragma : pragmas) {
+        QSqlQuery query(db);
+        if (!query.exec("PRAGMA " + pragma)) {
+            qDebug() << "Failed to set PRAGMA" << pragma << ":" << query.lastError().text();
+            ok = false;
+        }
+    }
+
+    // Report what SQLite actually accepted, not what was requested
+    qDebug().noquote() << QString("Database profile %1 (%8): journal_mode=%2 synchronous=%3 cache_size=%4 "
+                                  "temp_store=%5 mmap_size=%6 busy_timeout=%7")
+                              .arg(name,
+                                   pragmaValue(db, "journal_mode"),
+                                   pragmaValue(db, "synchronous"),
+                                   pragmaValue(db, "cache_size"),
+                                   pragmaValue(db, "temp_store"),
+                                   pragmaValue(db, "mmap_size"),
+                                   pragmaValue(db, "busy_timeout"),
+                                   db.connectionName());
+    return ok;
+}
@@ -0,0 +1,38 @@
+#ifndef CONNECTIONPROFILE_H
+#define CONNECTIONPROFILE_H
+
+#include <QSqlDatabase>
+#include <QString>
+
+// SQLite pragmas applied to every connection when it is opened
+struct ConnectionProfile
+{
+    QString name;
+    QString journalMode;    // journal_mode, e.g. WAL
+    QString synchronous;    // synchronous: OFF, NORMAL, FULL or EXTRA
+    int cacheSize;          // cache_size, negative values are KiB
+    QString tempStore;      // temp_store: DEFAULT, FILE or MEMORY
+    qint64 mmapSize;        // mmap_size in bytes
+    int busyTimeout;        // busy_timeout in milliseconds
+    int readerConnections;  // read-only connections for concurrent queries
+    int archiveAfterDays;   // older messages move to monthly archive files, 0 keeps all
+    int compressAbove;      // message bodies of this many bytes or more are compressed, 0 = never
+    bool compressionDictionary; // compress with a shared dictionary trained on past messages
+    int changePollMin;      // fastest check for commits by other processes, milliseconds
+    int changePollMax;      // slowest one, reached while they are quiet; 0 turns checking off
+    int slowQueryMs;        // operations taking longer are logged with their query plans, 0 = never
+
+    // Safe against power loss, every commit is synced
+    static ConnectionProfile durable();
+    // Commits are synced at WAL checkpoints only, larger caches
+    static ConnectionProfile fast();
+
+    // Reads the [database] section of an INI file. "profile" picks a
+    // preset and any other key overrides the matching preset value.
+    static ConnectionProfile fromConfig(const QString &path = "quickchat.ini");
+
+    // Read-only connections keep the journal mode chosen by the writer
+    bool apply(QSqlDatabase &db, bool readOnly = false) const;
+};
+
+#endif // CONNECTIONPROFILE_H
@@ -0,0 +1,351 @@
+#include "dbmigrations.h"
+#include "messagetime.h"
+
+#include <QSqlQuery>
+#include <QSqlError>
+#include <QDateTime>
+#include <QDebug>
+
+const QList<SchemaMigration> &schemaMigrations()
+{
+    static const QList<SchemaMigration> migrations = {
+        {1, "Index group messages by group and time",
+         {"CREATE INDEX IF NOT EXISTS idx_messages_group_time "
+          "ON messages (chatgroup_id, timestamp)"}},
+
+        {2, "Index direct messages by sender, recipient and time",
+         {"CREATE INDEX IF NOT EXISTS idx_messages_direct_time "
+          "ON messages (sender_id, recipient_id, timestamp)"}},
+
+        {3, "Index group memberships by group",
+         {"CREATE INDEX IF NOT EXISTS idx_user_chat_groups_group "
+          "ON user_chat_groups (chatgroup_id)"}},
+
+        // History is paged by message id, which replaces the timestamp indexes
+        {4, "Index group messages by group and id for keyset paging",
+         {"CREATE INDEX IF NOT EXISTS idx_messages_group_id "
+          "ON messages (chatgroup_id, id)",
+          "DROP INDEX IF EXISTS idx_messages_group_time"}},
+
+        {5, "Index direct messages by sender, recipient and id for keyset paging",
+         {"CREATE INDEX IF NOT EXISTS idx_messages_direct_id "
+          "ON messages (sender_id, recipient_id, id)",
+          "DROP INDEX IF EXISTS idx_messages_direct_time"}},
+
+        // Text timestamps parse slowly, sort as strings and drop sub-second order.
+        // The column keeps its declared type; NUMERIC affinity stores the integers as-is.
+        {6, "Store message timestamps as epoch milliseconds",
+         {QString("UPDATE messages SET timestamp = %1 WHERE typeof(timestamp) = 'text'")
+              .arg(legacyTimestampToStoredSql("timestamp"))}},
+
+        // Full-text index over message content, keyed by message id. System
+        // notices are not indexed. Triggers keep it in step with messages.
+        {7, "Add full-text search index for messages",
+         {"CREATE VIRTUAL TABLE IF NOT EXISTS messages_fts USING fts5("
+          "content, tokenize = 'unicode61 remove_diacritics 2')",
+          "INSERT INTO messages_fts (rowid, content) "
+          "SELECT id, content FROM messages WHERE type IS NOT 'system'",
+          "CREATE TRIGGER IF NOT EXISTS messages_fts_insert AFTER INSERT ON messages "
+          "WHEN new.type IS NOT 'system' BEGIN "
+          "INSERT INTO messages_fts (rowid, content) VALUES (new.id, new.content); "
+          "END",
+          "CREATE TRIGGER IF NOT EXISTS messages_fts_delete AFTER DELETE ON messages BEGIN "
+          "DELETE FROM messages_fts WHERE rowid = old.id; "
+          "END",
+          "CREATE TRIGGER IF NOT EXISTS messages_fts_update AFTER UPDATE OF content, type ON messages BEGIN "
+          "DELETE FROM messages_fts WHERE rowid = old.id; "
+          "INSERT INTO messages_fts (rowid, content) SELECT new.id, new.content WHERE new.type IS NOT 'system'; "
+          "END"}},
+
+        // One row per direct conversation (ordered user pair) or group, kept
+        // current by triggers so inbox views never aggregate over messages.
+        // Read cursors store the message_count a user had seen, so unread is
+        // a subtraction.
+        {8, "Add conversation summaries and read cursors",
+         {"CREATE TABLE IF NOT EXISTS conversations ("
+          "id INTEGER PRIMARY KEY AUTOINCREMENT, "
+          "kind TEXT NOT NULL CHECK (kind IN ('direct', 'group')), "
+          "chatgroup_id INTEGER UNIQUE, "
+          "user_low INTEGER, "
+          "user_high INTEGER, "
+          "last_message_id INTEGER NOT NULL DEFAULT 0, "
+          "last_timestamp INTEGER NOT NULL DEFAULT 0, "
+          "message_count INTEGER NOT NULL DEFAULT 0, "
+          "UNIQUE (user_low, user_high), "
+          "FOREIGN KEY (chatgroup_id) REFERENCES chat_groups (id), "
+          "FOREIGN KEY (user_low) REFERENCES users (id), "
+          "FOREIGN KEY (user_high) REFERENCES users (id)"
+          ")",
+          "CREATE INDEX IF NOT EXISTS idx_conversations_user_high ON conversations (user_high)",
+          "CREATE TABLE IF NOT EXISTS conversation_reads ("
+          "conversation_id INTEGER NOT NULL, "
+          "user_id INTEGER NOT NULL, "
+          "last_read_message_id INTEGER NOT NULL DEFAULT 0, "
+          "read_count INTEGER NOT NULL DEFAULT 0, "
+          "PRIMARY KEY (conversation_id, user_id), "
+          "FOREIGN KEY (conversation_id) REFERENCES conversations (id), "
+          "FOREIGN KEY (user_id) REFERENCES users (id)"
+          ") WITHOUT ROWID",
+
+          // Backfill; the bare timestamp column comes from the MAX(id) row
+          "INSERT INTO conversations (kind, chatgroup_id, last_message_id, last_timestamp, message_count) "
+          "SELECT 'group', g.id, COALESCE(s.last_id, 0), COALESCE(s.last_timestamp, 0), COALESCE(s.message_count, 0) "
+          "FROM chat_groups g LEFT JOIN ("
+          "SELECT chatgroup_id, MAX(id) AS last_id, timestamp AS last_timestamp, COUNT(*) AS message_count "
+          "FROM messages WHERE chatgroup_id IS NOT NULL GROUP BY chatgroup_id"
+          ") s ON s.chatgroup_id = g.id",
+          "INSERT INTO conversations (kind, user_low, user_high, last_message_id, last_timestamp, message_count) "
+          "SELECT 'direct', MIN(sender_id, recipient_id) AS low, MAX(sender_id, recipient_id) AS high, "
+          "MAX(id), timestamp, COUNT(*) "
+          "FROM messages WHERE recipient_id IS NOT NULL GROUP BY low, high",
+
+          // Existing history counts as read, so upgrading doesn't flood the inbox
+          "INSERT INTO conversation_reads (conversation_id, user_id, last_read_message_id, read_count) "
+          "SELECT c.id, ucg.user_id, c.last_message_id, c.message_count "
+          "FROM conversations c JOIN user_chat_groups ucg ON ucg.chatgroup_id = c.chatgroup_id",
+          "INSERT OR IGNORE INTO conversation_reads (conversation_id, user_id, last_read_message_id, read_count) "
+          "SELECT id, user_low, last_message_id, message_count FROM conversations WHERE kind = 'direct' "
+          "UNION ALL "
+          "SELECT id, user_high, last_message_id, message_count FROM conversations WHERE kind = 'direct'",
+
+          "CREATE TRIGGER IF NOT EXISTS conversations_group_created AFTER INSERT ON chat_groups BEGIN "
+          "INSERT OR IGNORE INTO conversations (kind, chatgroup_id) VALUES ('group', new.id); "
+          "END",
+          "CREATE TRIGGER IF NOT EXISTS conversations_group_deleted AFTER DELETE ON chat_groups BEGIN "
+          "DELETE FROM conversation_reads WHERE conversation_id IN "
+          "(SELECT id FROM conversations WHERE chatgroup_id = old.id); "
+          "DELETE FROM conversations WHERE chatgroup_id = old.id; "
+          "END",
+
+          "CREATE TRIGGER IF NOT EXISTS conversations_group_message AFTER INSERT ON messages "
+          "WHEN new.chatgroup_id IS NOT NULL BEGIN "
+          "INSERT INTO conversations (kind, chatgroup_id, last_message_id, last_timestamp, message_count) "
+          "VALUES ('group', new.chatgroup_id, new.id, new.timestamp, 1) "
+          "ON CONFLICT (chatgroup_id) DO UPDATE SET last_message_id = excluded.last_message_id, "
+          "last_timestamp = excluded.last_timestamp, message_count = message_count + 1; "
+          "END",
+          "CREATE TRIGGER IF NOT EXISTS conversations_direct_message AFTER INSERT ON messages "
+          "WHEN new.recipient_id IS NOT NULL BEGIN "
+          "INSERT INTO conversations (kind, user_low, user_high, last_message_id, last_timestamp, message_count) "
+          "VALUES ('direct', MIN(new.sender_id, new.recipient_id), MAX(new.sender_id, new.recipient_id), "
+          "new.id, new.timestamp, 1) "
+          "ON CONFLICT (user_low, user_high) DO UPDATE SET last_message_id = excluded.last_message_id, "
+          "last_timestamp = excluded.last_timestamp, message_count = message_count + 1; "
+          "END",
+
+          // Deleting the newest message moves last_message_id back to the one before it
+          "CREATE TRIGGER IF NOT EXISTS conversations_group_message_deleted AFTER DELETE ON messages "
+          "WHEN old.chatgroup_id IS NOT NULL BEGIN "
+          "UPDATE conversations SET message_count = message_count - 1 WHERE chatgroup_id = old.chatgroup_id; "
+          "UPDATE conversations SET "
+          "last_message_id = COALESCE((SELECT MAX(id) FROM messages WHERE chatgroup_id = old.chatgroup_id), 0) "
+          "WHERE chatgroup_id = old.chatgroup_id AND last_message_id = old.id; "
+          "UPDATE conversations SET "
+          "last_timestamp = COALESCE((SELECT timestamp FROM messages WHERE id = conversations.last_message_id), 0) "
+          "WHERE chatgroup_id = old.chatgroup_id; "
+          "END",
+          "CREATE TRIGGER IF NOT EXISTS conversations_direct_message_deleted AFTER DELETE ON messages "
+          "WHEN old.recipient_id IS NOT NULL BEGIN "
+          "UPDATE conversations SET message_count = message_count - 1 "
+          "WHERE user_low = MIN(old.sender_id, old.recipient_id) AND user_high = MAX(old.sender_id, old.recipient_id); "
+          "UPDATE conversations SET last_message_id = MAX("
+          "COALESCE((SELECT MAX(id) FROM messages WHERE sender_id = old.sender_id AND recipient_id = old.recipient_id), 0), "
+          "COALESCE((SELECT MAX(id) FROM messages WHERE sender_id = old.recipient_id AND recipient_id = old.sender_id), 0)) "
+          "WHERE user_low = MIN(old.sender_id, old.recipient_id) AND user_high = MAX(old.sender_id, old.recipient_id) "
+          "AND last_message_id = old.id; "
+          "UPDATE conversations SET "
+          "last_timestamp = COALESCE((SELECT timestamp FROM messages WHERE id = conversations.last_message_id), 0) "
+          "WHERE user_low = MIN(old.sender_id, old.recipient_id) AND user_high = MAX(old.sender_id, old.recipient_id); "
+          "END"}},
+
+        // Group listings read a stored count instead of aggregating memberships.
+        // ChatDatabaseHandler keeps it current alongside membership changes.
+        {9, "Store group member counts on chat_groups",
+         {"ALTER TABLE chat_groups ADD COLUMN member_count INTEGER NOT NULL DEFAULT 0",
+          "UPDATE chat_groups SET member_count = "
+          "(SELECT COUNT(*) FROM user_chat_groups ucg WHERE ucg.chatgroup_id = chat_groups.id)",
+          "CREATE INDEX IF NOT EXISTS idx_chat_groups_created_by ON chat_groups (created_by)"}},
+
+        // Old messages move to monthly archive files (see messagearchive.h).
+        // archive_sweep only has a row inside a sweep transaction; the delete
+        // triggers skip the conversation summaries then, because archived
+        // messages still belong to their conversation.
+        {10, "Add message archive tiers",
+         {"CREATE TABLE IF NOT EXISTS message_archives ("
+          "month TEXT PRIMARY KEY, "
+          "file_name TEXT NOT NULL, "
+          "min_id INTEGER NOT NULL, "
+          "max_id INTEGER NOT NULL"
+          ")",
+          "CREATE TABLE IF NOT EXISTS archive_sweep (active INTEGER NOT NULL)",
+          "DROP TRIGGER IF EXISTS conversations_group_message_deleted",
+          "CREATE TRIGGER conversations_group_message_deleted AFTER DELETE ON messages "
+          "WHEN old.chatgroup_id IS NOT NULL AND NOT EXISTS (SELECT 1 FROM archive_sweep) BEGIN "
+          "UPDATE conversations SET message_count = message_count - 1 WHERE chatgroup_id = old.chatgroup_id; "
+          "UPDATE conversations SET "
+          "last_message_id = COALESCE((SELECT MAX(id) FROM messages WHERE chatgroup_id = old.chatgroup_id), 0) "
+          "WHERE chatgroup_id = old.chatgroup_id AND last_message_id = old.id; "
+          "UPDATE conversations SET "
+          "last_timestamp = COALESCE((SELECT timestamp FROM messages WHERE id = conversations.last_message_id), 0) "
+          "WHERE chatgroup_id = old.chatgroup_id; "
+          "END",
+          "DROP TRIGGER IF EXISTS conversations_direct_message_deleted",
+          "CREATE TRIGGER conversations_direct_message_deleted AFTER DELETE ON messages "
+          "WHEN old.recipient_id IS NOT NULL AND NOT EXISTS (SELECT 1 FROM archive_sweep) BEGIN "
+          "UPDATE conversations SET message_count = message_count - 1 "
+          "WHERE user_low = MIN(old.sender_id, old.recipient_id) AND user_high = MAX(old.sender_id, old.recipient_id); "
+          "UPDATE conversations SET last_message_id = MAX("
+          "COALESCE((SELECT MAX(id) FROM messages WHERE sender_id = old.sender_id AND recipient_id = old.recipient_id), 0), "
+          "COALESCE((SELECT MAX(id) FROM messages WHERE sender_id = old.recipient_id AND recipient_id = old.sender_id), 0)) "
+          "WHERE user_low = MIN(old.sender_id, old.recipient_id) AND user_high = MAX(old.sender_id, old.recipient_id) "
+          "AND last_message_id = old.id; "
+          "UPDATE conversations SET "
+          "last_timestamp = COALESCE((SELECT timestamp FROM messages WHERE id = conversations.last_message_id), 0) "
+          "WHERE user_low = MIN(old.sender_id, old.recipient_id) AND user_high = MAX(old.sender_id, old.recipient_id); "
+          "END"}},
+
+        // Large bodies may be stored compressed (see messagecodec.h). The
+        // full-text triggers only index plain text; ChatDatabaseHandler
+        // indexes the text of compressed rows itself.
+        {11, "Add compression dictionaries and skip compressed rows in the search triggers",
+         {"CREATE TABLE IF NOT EXISTS content_dictionaries ("
+          "id INTEGER PRIMARY KEY AUTOINCREMENT, "
+          "dictionary BLOB NOT NULL, "
+          "created_at INTEGER NOT NULL"
+          ")",
+          "DROP TRIGGER IF EXISTS messages_fts_insert",
+          "CREATE TRIGGER messages_fts_insert AFTER INSERT ON messages "
+          "WHEN new.type IS NOT 'system' AND typeof(new.content) = 'text' BEGIN "
+          "INSERT INTO messages_fts (rowid, content) VALUES (new.id, new.content); "
+          "END",
+          "DROP TRIGGER IF EXISTS messages_fts_update",
+          "CREATE TRIGGER messages_fts_update AFTER UPDATE OF content, type ON messages BEGIN "
+          "DELETE FROM messages_fts WHERE rowid = old.id; "
+          "INSERT INTO messages_fts (rowid, content) SELECT new.id, new.content "
+          "WHERE new.type IS NOT 'system' AND typeof(new.content) = 'text'; "
+          "END"}},
+
+        // Direct messages carry the id of their conversations row, so a DM
+        // page is one range on (conversation_id, id) whichever way the
+        // messages went. ChatDatabaseHandler binds it on insert; the trigger
+        // fills it in for the first message of a conversation and for rows
+        // written by anything else. Group messages keep it NULL and stay out
+        // of the index.
+        {12, "Key direct messages by conversation id",
+         {"ALTER TABLE messages ADD COLUMN conversation_id INTEGER REFERENCES conversations (id)",
+          "UPDATE messages SET conversation_id = (SELECT c.id FROM conversations c "
+          "WHERE c.user_low = MIN(messages.sender_id, messages.recipient_id) "
+          "AND c.user_high = MAX(messages.sender_id, messages.recipient_id)) "
+          "WHERE recipient_id IS NOT NULL",
+          "CREATE INDEX IF NOT EXISTS idx_messages_conversation_id "
+          "ON messages (conversation_id, id) WHERE conversation_id IS NOT NULL",
+          "DROP INDEX IF EXISTS idx_messages_direct_id",
+          "CREATE TRIGGER IF NOT EXISTS messages_direct_conversation AFTER INSERT ON messages "
+          "WHEN new.recipient_id IS NOT NULL AND new.conversation_id IS NULL BEGIN "
+          "INSERT OR IGNORE INTO conversations (kind, user_low, user_high) "
+          "VALUES ('direct', MIN(new.sender_id, new.recipient_id), MAX(new.sender_id, new.recipient_id)); "
+          "UPDATE messages SET conversation_id = (SELECT id FROM conversations "
+          "WHERE user_low = MIN(new.sender_id, new.recipient_id) AND user_high = MAX(new.sender_id, new.recipient_id)) "
+          "WHERE id = new.id; "
+          "END",
+          "DROP TRIGGER IF EXISTS conversations_direct_message_deleted",
+          "CREATE TRIGGER conversations_direct_message_deleted AFTER DELETE ON messages "
+          "WHEN old.recipient_id IS NOT NULL AND NOT EXISTS (SELECT 1 FROM archive_sweep) BEGIN "
+          "UPDATE conversations SET message_count = message_count - 1 WHERE id = old.conversation_id; "
+          "UPDATE conversations SET "
+          "last_message_id = COALESCE((SELECT MAX(id) FROM messages WHERE conversation_id = old.conversation_id), 0) "
+          "WHERE id = old.conversation_id AND last_message_id = old.id; "
+          "UPDATE conversations SET "
+          "last_timestamp = COALESCE((SELECT timestamp FROM messages WHERE id = conversations.last_message_id), 0) "
+          "WHERE id = old.conversation_id; "
+          "END"}},
+
+        // Other processes sharing the file learn about new messages from the
+        // ids; group and membership changes bump this counter instead
+        {13, "Count group and membership changes",
+         {"CREATE TABLE IF NOT EXISTS change_counters ("
+          "name TEXT PRIMARY KEY, "
+          "value INTEGER NOT NULL"
+          ")",
+          "INSERT OR IGNORE INTO change_counters (name, value) VALUES ('groups', 0)",
+          "CREATE TRIGGER IF NOT EXISTS change_counters_group_created AFTER INSERT ON chat_groups BEGIN "
+          "UPDATE change_counters SET value = value + 1 WHERE name = 'groups'; "
+          "END",
+          "CREATE TRIGGER IF NOT EXISTS change_counters_group_updated AFTER UPDATE ON chat_groups BEGIN "
+          "UPDATE change_counters SET value = value + 1 WHERE name = 'groups'; "
+          "END",
+          "CREATE TRIGGER IF NOT EXISTS change_counters_group_deleted AFTER DELETE ON chat_groups BEGIN "
+          "UPDATE change_counters SET value = value + 1 WHERE name = 'groups'; "
+          "END",
+          "CREATE TRIGGER IF NOT EXISTS change_counters_member_added AFTER INSERT ON user_chat_groups BEGIN "
+          "UPDATE change_counters SET value = value + 1 WHERE name = 'groups'; "
+          "END",
+          "CREATE TRIGGER IF NOT EXISTS change_counters_member_removed AFTER DELETE ON user_chat_groups BEGIN "
+          "UPDATE change_counters SET value = value + 1 WHERE name = 'groups'; "
+          "END"}},
+    };
+    return migrations;
+}
+
+int currentSchemaVersion(QSqlDatabase &db)
+{
+    QSqlQuery query(db);
+    if (query.exec("SELECT COALESCE(MAX(version), 0) FROM schema_version") && query.next()) {
+        return query.value(0).toInt();
+    }
+    return 0;
+}
+
+bool runSchemaMigrations(QSqlDatabase &db)
+{
+    QSqlQuery query(db);
+    if (!query.exec("CREATE TABLE IF NOT EXISTS schema_version ("
+                    "version INTEGER PRIMARY KEY, "
+                    "description TEXT NOT NULL, "
+                    "applied_at DATETIME NOT NULL"
+                    ")")) {
+        qDebug() << "Failed to create schema_version table:" << query.lastError().text();
+        return false;
+    }
+
+    int version = currentSchemaVersion(db);
+
+    for (const SchemaMigration &migration : schemaMigrations()) {
+        if (migration.version <= version) {
+            continue;
+        }
+
+        // Each migration either applies completely or not at all
+        if (!db.transaction()) {
+            qDebug() << "Failed to start migration" << migration.version << ":" << db.lastError().text();
+            return false;
+        }
+
+        for (const QString &sql : migration.statements) {
+            QSqlQuery step(db);
+            if (!step.exec(sql)) {
+                qDebug() << "Migration" << migration.version << "failed:" << step.lastError().text();
+                qDebug() << "SQL:" << sql;
+                db.rollback();
+                return false;
+            }
+        }
+
+        QSqlQuery record(db);
+        record.prepare("INSERT INTO schema_version (version, description, applied_at) "
+                       "VALUES (:version, :description, :applied_at)");
+        record.bindValue(":version", migration.version);
+        record.bindValue(":description", migration.description);
+        record.bindValue(":applied_at", QDateTime::currentDateTime().toString("yyyy-MM-dd hh:mm:ss"));
+        if (!record.exec() || !db.commit()) {
+            qDebug() << "Failed to record migration" << migration.version << ":" << record.lastError().text();
+            db.rollback();
+            return false;
+        }
+
+        qDebug() << "Applied schema migration" << migration.version << "-" << migration.description;
+        version = migration.version;
+    }
+
+    return true;
+}
@@ -0,0 +1,26 @@
+#ifndef DBMIGRATIONS_H
+#define DBMIGRATIONS_H
+
+#include <QSqlDatabase>
+#include <QString>
+#include <QStringList>
+#include <QList>
+
+// A single schema change, applied once and recorded in schema_version
+struct SchemaMigration
+{
+    int version;
+    QString description;
+    QStringList statements;
+};
+
+// All migrations in the order they must be applied
+const QList<SchemaMigration> &schemaMigrations();
+
+// Highest applied migration version, 0 for a database that was never migrated
+int currentSchemaVersion(QSqlDatabase &db);
+
+// Applies every pending migration, each in its own transaction
+bool runSchemaMigrations(QSqlDatabase &db);
+
+#endif // DBMIGRATIONS_H
@@ -0,0 +1,108 @@
+#include "dbworker.h"
+#include "setup_db.h"
+
+ChatDatabaseWorker::ChatDatabaseWorker(QObject *parent)
+    : QObject(parent), handler(new ChatDatabaseHandler()), batcher(new MessageWriteBatcher(handler))
+    , readers(handler->profile().readerConnections), changePollInterval(0)
+{
+    handler->setConnectionName("quickchat_writer");
+    handler->moveToThread(&thread);
+    batcher->moveToThread(&thread);
+
+    // The handler closes its connection on the thread that opened it
+    connect(&thread, &QThread::finished, batcher, &QObject::deleteLater);
+    connect(&thread, &QThread::finished, handler, &QObject::deleteLater);
+
+    // Queued over from the database thread
+    connect(handler, &ChatDatabaseHandler::messageInserted, this, &ChatDatabaseWorker::messageInserted);
+    connect(handler, &ChatDatabaseHandler::membershipChanged, this, &ChatDatabaseWorker::membershipChanged);
+    connect(handler, &ChatDatabaseHandler::groupRenamed, this, &ChatDatabaseWorker::groupRenamed);
+    connect(handler, &ChatDatabaseHandler::groupDeleted, this, &ChatDatabaseWorker::groupDeleted);
+    connect(handler, &ChatDatabaseHandler::groupsChangedExternally, this, &ChatDatabaseWorker::groupsChangedExternally);
+
+    changePoll.setSingleShot(true);
+    connect(&changePoll, &QTimer::timeout, this, &ChatDatabaseWorker::pollExternalChanges);
+}
+
+ChatDatabaseWorker::~ChatDatabaseWorker()
+{
+    changePoll.stop();
+    if (thread.isRunning()) {
+        // Write out messages still waiting for their batch
+        QMetaObject::invokeMethod(batcher, &MessageWriteBatcher::flush, Qt::BlockingQueuedConnection);
+    }
+    thread.quit();
+    thread.wait();
+}
+
+QFuture<bool> ChatDatabaseWorker::start()
+{
+    if (!thread.isRunning()) {
+        thread.setObjectName("QuickChat database");
+        thread.start();
+    }
+
+    writerReady = run([](ChatDatabaseHandler &db) {
+        setup_chat_db(); // create and seed the database on first run
+        return db.initialize();
+    });
+
+    // Housekeeping, queued behind the open so readers don't wait for it;
+    // writes queued meanwhile run after it. Moves cold history to the
+    // archive files and, the first time a shared compression dictionary is
+    // enabled, learns one from the existing messages.
+    run([](ChatDatabaseHandler &db) {
+        const ConnectionProfile &profile = db.profile();
+        db.archiveOldMessages(profile.archiveAfterDays);
+        if (profile.compressAbove > 0 && profile.compressionDictionary && db.compressionDictionaryId() < 0) {
+            db.trainCompressionDictionary();
+        }
+    });
+
+    const ConnectionProfile &profile = handler->profile();
+    if (profile.changePollMax > 0 && !changePoll.isActive()) {
+        changePollInterval = qMax(1, profile.changePollMin);
+        changePoll.start(changePollInterval);
+    }
+    return writerReady;
+}
+
+void ChatDatabaseWorker::pollExternalChanges()
+{
+    run([](ChatDatabaseHandler &db) {
+        return db.checkExternalChanges();
+    }).then(this, [this](bool changed) {
+        // Other processes tend to write in bursts; back off while they are quiet
+        const ConnectionProfile &profile = handler->profile();
+        int fastest = qMax(1, profile.changePollMin);
+        changePollInterval = changed ? fastest : qBound(fastest, changePollInterval * 2, profile.changePollMax);
+        changePoll.start(changePollInterval);
+    });
+}
+
+QFuture<qint64> ChatDatabaseWorker::queueDirectMessage(const QString &sender, const QString &recipient,
+                                                       const QString &content)
+{
+    MessageWriteBatcher *target = batcher;
+    return run([target, sender, recipient, content](ChatDatabaseHandler &) {
+        return target->queueDirectMessage(sender, recipient, content);
+    }).unwrap();
+}
+
+QFuture<qint64> ChatDatabaseWorker::queueGroupMessage(const QString &sender, const QString &groupName,
+                                                      const QString &content, const QString &type)
+{
+    MessageWriteBatcher *target = batcher;
+    return run([target, sender, groupName, content, type](ChatDatabaseHandler &) {
+        return target->queueGroupMessage(sender, groupName, content, type);
+    }).unwrap();
+}
+
+QFuture<qint64> ChatDatabaseWorker::queueGroupMessage(const QString &sender, int groupId,
+                                                      const QString &content, const QString &type)
+{
+    MessageWriteBatcher *target = batcher;
+    return run([target, sender, groupId, content, type](ChatDatabaseHandler &) {
+        return target->queueGroupMessage(sender, groupId, content, type);
+    }).unwrap();
+}
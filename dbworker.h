@@ -0,0 +1,130 @@
+#ifndef DBWORKER_H
+#define DBWORKER_H
+
+#include <QObject>
+#include <QThread>
+#include <QTimer>
+#include <QFuture>
+#include <QPromise>
+#include <memory>
+#include <type_traits>
+
+#include "chatdbhandler.h"
+#include "connectionpool.h"
+#include "writebatcher.h"
+
+// Owns a ChatDatabaseHandler (and its SQLite connection) on a dedicated
+// thread. Requests are queued to that thread in order and each one
+// returns a QFuture; attach QFuture::then(this, ...) to get the result
+// back on the calling widget's thread. Pure reads can go through read()
+// instead, which runs them concurrently on the reader connection pool.
+// Committed writes are announced through the signals below, including
+// those of other processes sharing the database file.
+class ChatDatabaseWorker : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit ChatDatabaseWorker(QObject *parent = nullptr);
+    ~ChatDatabaseWorker();
+
+    // Starts the thread, creates the database if needed and opens the connection
+    QFuture<bool> start();
+
+    // Runs function(handler) on the database thread
+    template <typename Function>
+    auto run(Function function) -> QFuture<std::invoke_result_t<Function, ChatDatabaseHandler &>>;
+
+    // Runs function(handler) on a pooled read-only connection. Reads are
+    // not ordered against each other, but see every write whose future
+    // has already finished. Cancelling the future skips a read that has
+    // not started yet.
+    template <typename Function>
+    auto read(Function function) -> QFuture<std::invoke_result_t<Function, ChatDatabaseHandler &>>;
+
+    // Message inserts, committed in batches; each resolves to the new
+    // message id (or -1) once its batch is on disk
+    QFuture<qint64> queueDirectMessage(const QString &sender, const QString &recipient, const QString &content);
+    QFuture<qint64> queueGroupMessage(const QString &sender, const QString &groupName,
+                                      const QString &content, const QString &type = "text");
+    QFuture<qint64> queueGroupMessage(const QString &sender, int groupId,
+                                      const QString &content, const QString &type = "text");
+
+signals:
+    // The handler's change notifications, delivered on the worker's thread
+    // after the write committed. Views filter for their own conversation
+    // and re-read through read(), which already sees the change.
+    void messageInserted(qint64 messageId, int groupId, const QString &senderEmail, const QString &recipientEmail);
+    void membershipChanged(int groupId, const QString &userEmail, bool joined);
+    void groupRenamed(int groupId, const QString &newName);
+    void groupDeleted(int groupId);
+    // Another process changed groups or memberships; views reload what they show
+    void groupsChangedExternally();
+
+private:
+    // Checks for commits by other processes, soon after the last one found
+    // and less often (up to the profile's changePollMax) while none come
+    void pollExternalChanges();
+
+    QThread thread;
+    ChatDatabaseHandler *handler; // lives on `thread`
+    MessageWriteBatcher *batcher; // lives on `thread`
+    ChatConnectionPool readers;
+    QFuture<bool> writerReady;    // the schema exists once this finishes
+    QTimer changePoll;
+    int changePollInterval;
+};
+
+template <typename Function>
+auto ChatDatabaseWorker::run(Function function) -> QFuture<std::invoke_result_t<Function, ChatDatabaseHandler &>>
+{
+    using Result = std::invoke_result_t<Function, ChatDatabaseHandler &>;
+
+    auto promise = std::make_shared<QPromise<Result>>();
+    QFuture<Result> future = promise->future();
+    promise->start();
+
+    ChatDatabaseHandler *target = handler;
+    QMetaObject::invokeMethod(handler, [target, promise, function]() {
+        if constexpr (std::is_void_v<Result>) {
+            function(*target);
+        } else {
+            promise->addResult(function(*target));
+        }
+        promise->finish();
+    }, Qt::QueuedConnection);
+
+    return future;
+}
+
+template <typename Function>
+auto ChatDatabaseWorker::read(Function function) -> QFuture<std::invoke_result_t<Function, ChatDatabaseHandler &>>
+{
+    using Result = std::invoke_result_t<Function, ChatDatabaseHandler &>;
+
+    auto promise = std::make_shared<QPromise<Result>>();
+    QFuture<Result> future = promise->future();
+    promise->start();
+
+    ChatConnectionPool *pool = &readers;
+    QFuture<bool> ready = writerReady;
+    readers.readerThreads()->start([pool, ready, promise, function]() mutable {
+        ready.waitForFinished();
+        if (promise->isCanceled()) {
+            // Cancelled while queued, e.g. a search the user has typed past
+            promise->finish();
+            return;
+        }
+        ChatDatabaseHandler *reader = pool->readerForCurrentThread();
+        if constexpr (std::is_void_v<Result>) {
+            function(*reader);
+        } else {
+            promise->addResult(function(*reader));
+        }
+        promise->finish();
+    });
+
+    return future;
+}
+
+#endif // DBWORKER_H
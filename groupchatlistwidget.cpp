@@ -4,12 +4,23 @@
 #include <QFont>
 #include <QIcon>
 
-GroupChatListWidget::GroupChatListWidget(ChatDatabaseHandler &dbHandler, const QString &userEmail, QWidget *parent)
-    : QWidget(parent), dbHandler(dbHandler), userEmail(userEmail)
+GroupChatListWidget::GroupChatListWidget(ChatDatabaseWorker &dbWorker, const QString &userEmail, QWidget *parent)
+    : QWidget(parent), dbWorker(dbWorker), userEmail(userEmail)
 {
     setupUI();
     loadCreatedGroups();
     loadJoinedGroups();
+
+    // Reload when a group the user is in changes, wherever the change was made
+    connect(&dbWorker, &ChatDatabaseWorker::membershipChanged, this,
+            [this](int, const QString &email, bool) {
+        if (email == this->userEmail) {
+            refreshGroupLists();
+        }
+    });
+    connect(&dbWorker, &ChatDatabaseWorker::groupRenamed, this, &GroupChatListWidget::refreshGroupLists);
+    connect(&dbWorker, &ChatDatabaseWorker::groupDeleted, this, &GroupChatListWidget::refreshGroupLists);
+    connect(&dbWorker, &ChatDatabaseWorker::groupsChangedExternally, this, &GroupChatListWidget::refreshGroupLists);
 }
 
 void GroupChatListWidget::setupUI()
@@ -141,20 +152,33 @@ void GroupChatListWidget::setupTabStyle()
 
 void GroupChatListWidget::loadCreatedGroups()
 {
-    createdGroupsListWidget->clear();
-    QList<std::tuple<QString, QString, int>> groups = dbHandler.getCreatedGroups(userEmail);
-    for (const auto &group : groups) {
-        QString id = std::get<0>(group);
-        QString name = std::get<1>(group);
-        int memberCount = std::get<2>(group);
-        addGroupItemWithEditButton(id, name, memberCount, createdGroupsListWidget);
-    }
+    QString email = userEmail;
+    dbWorker.read([email](ChatDatabaseHandler &db) {
+        return db.getCreatedGroups(email);
+    }).then(this, [this](const QList<std::tuple<QString, QString, int>> &groups) {
+        createdGroupsListWidget->clear();
+        for (const auto &group : groups) {
+            QString id = std::get<0>(group);
+            QString name = std::get<1>(group);
+            int memberCount = std::get<2>(group);
+            addGroupItemWithEditButton(id, name, memberCount, createdGroupsListWidget);
+        }
+    });
 }
 
 void GroupChatListWidget::loadJoinedGroups()
+{
+    QString email = userEmail;
+    dbWorker.read([email](ChatDatabaseHandler &db) {
+        return db.getJoinedGroups(email);
+    }).then(this, [this](const QList<std::tuple<QString, QString, int>> &groups) {
+        showJoinedGroups(groups);
+    });
+}
+
+void GroupChatListWidget::showJoinedGroups(const QList<std::tuple<QString, QString, int>> &groups)
 {
     joinedGroupsListWidget->clear();
-    QList<std::tuple<QString, QString, int>> groups = dbHandler.getJoinedGroups(userEmail);
 
     for (const auto &group : groups) {
         QString id = std::get<0>(group);
@@ -255,6 +279,7 @@ void GroupChatListWidget::addGroupItemWithEditButton(const QString &groupId, con
 
     QPushButton *editButton = new QPushButton("Edit", itemWidget);
     editButton->setProperty("groupName", groupName);
+    editButton->setProperty("groupId", groupId.toInt());
     editButton->setCursor(Qt::PointingHandCursor);
     editButton->setFixedSize(35, 22);
     editButton->setStyleSheet(
@@ -312,6 +337,7 @@ void GroupChatListWidget::onEditGroupNameClicked()
     if (!editButton) return;
 
     QString oldGroupName = editButton->property("groupName").toString();
+    int groupId = editButton->property("groupId").toInt();
     bool ok;
     QString newGroupName = QInputDialog::getText(this, "Edit Group Name",
                                                "Enter new group name:",
@@ -320,12 +346,14 @@ void GroupChatListWidget::onEditGroupNameClicked()
 
     if (ok && !newGroupName.isEmpty() && newGroupName != oldGroupName) {
         // Update the group name in database
-        // Note: You'll need to add this function to ChatDatabaseHandler
-        if (dbHandler.updateGroupName(oldGroupName, newGroupName)) {
-            refreshGroupLists();
-        } else {
-            QMessageBox::warning(this, "Error", "Failed to update group name.");
-        }
+        dbWorker.run([groupId, newGroupName](ChatDatabaseHandler &db) {
+            return db.updateGroupName(groupId, newGroupName);
+        }).then(this, [this](bool updated) {
+            // The lists reload through groupRenamed
+            if (!updated) {
+                QMessageBox::warning(this, "Error", "Failed to update group name.");
+            }
+        });
     }
 }
 
@@ -344,11 +372,14 @@ void GroupChatListWidget::onDeleteGroupClicked()
     );
 
     if (reply == QMessageBox::Yes) {
-        if (dbHandler.deleteGroup(groupId)) {
-            refreshGroupLists();
-        } else {
-            QMessageBox::critical(this, "Error", "Failed to delete the group.");
-        }
+        dbWorker.run([groupId](ChatDatabaseHandler &db) {
+            return db.deleteGroup(groupId);
+        }).then(this, [this](bool deleted) {
+            // The lists reload through groupDeleted
+            if (!deleted) {
+                QMessageBox::critical(this, "Error", "Failed to delete the group.");
+            }
+        });
     }
 }
 
@@ -9,14 +9,14 @@
 #include <QListWidget>
 #include <QScrollArea>
 #include <QTabWidget>
-#include "chatdbhandler.h"
+#include "dbworker.h"
 
 class GroupChatListWidget : public QWidget
 {
     Q_OBJECT
 
 public:
-    explicit GroupChatListWidget(ChatDatabaseHandler &dbHandler, const QString &userEmail, QWidget *parent = nullptr);
+    explicit GroupChatListWidget(ChatDatabaseWorker &dbWorker, const QString &userEmail, QWidget *parent = nullptr);
     void refreshGroupLists();
 
 signals:
@@ -34,9 +34,10 @@ private:
     void loadJoinedGroups();
     void setupTabStyle();
     void addGroupItemWithEditButton(const QString &groupId, const QString &groupName, int memberCount, QListWidget *listWidget);
+    void showJoinedGroups(const QList<std::tuple<QString, QString, int>> &groups);
 
 
-    ChatDatabaseHandler &dbHandler;
+    ChatDatabaseWorker &dbWorker;
     QString userEmail;
     
     // UI Components
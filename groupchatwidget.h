@@ -1,93 +1,115 @@
-#ifndef GROUPCHATWIDGET_H
-#define GROUPCHATWIDGET_H
-
-#include <QWidget>
-#include <QVBoxLayout>
-#include <QHBoxLayout>
-#include <QMessageBox>
-#include <QLabel>
-#include <QPushButton>
-#include <QLineEdit>
-#include <QTextEdit>
-#include <QListWidget>
-#include <QSplitter>
-#include <QFrame>
-#include <QSqlDatabase>
-#include <QSqlQuery>
-#include <QSqlError>
-#include <QDateTime>
-#include <QScrollBar>
-#include <QMenu>
-#include <QTimer>
-#include <tuple>
-#include <QWidgetAction>
-
-
-#include "chatdbhandler.h"
-
-class GroupChatWidget : public QWidget
-{
-    Q_OBJECT
-
-public:
-    explicit GroupChatWidget(ChatDatabaseHandler &dbHandler, QString groupId, QPair<QString, QString> currentUser, QWidget *parent = nullptr);
-    ~GroupChatWidget();
-
-    void setGroupName(const QString &name);
-    QString getGroupName() const;
-    void setGroupId(const QString &id) {groupId = id;}
-    void setGroupAdmin(const QPair<QString, QString> & groupAdmin){this->groupAdmin = groupAdmin;}
-    void setMembersList();
-    void addMember(const QString &username);
-    void removeMember(const QString &username);
-    void clearChatHistory();
-    void loadChatHistory();
-    void addSystemMessage(const QString &message, QDateTime msgTimestamp = QDateTime::currentDateTime());
-
-    void addIncomingMessage(const QString &sender, const QString &email, const QString &message, QDateTime msgTimestamp);
-
-    void addOutgoingMessage(const QString &message, QDateTime msgTimestamp = QDateTime::currentDateTime());
-    void updateMembersHeader();
-
-signals:
-    void backRequested();
-    void messageSubmitted(const QString &message);
-
-private slots:
-    void sendMessage();
-    void showMembersMenu();
-    void leaveChatRequested();
-    void handleMemberClicked(QListWidgetItem *item);
-
-private:
-    void setupUI();
-    void setupConnections();
-
-    QLabel *groupNameLabel;
-    QPushButton *backButton;
-    QPushButton *leaveChatButton;
-    QPushButton *membersButton;
-    QMenu *membersMenu;
-
-    QTextEdit *chatHistoryDisplay;
-    QLineEdit *messageInputField;
-    QPushButton *sendMessageButton;
-    QListWidget *membersListWidget;
-    QMessageBox *confirmBox;
-    QMessageBox *errorBox;
-    QPushButton *addMemberButton;
-
-
-    QPair<QString, QString> currentUser; // name, email
-    QPair<QString, QString> groupAdmin; // name, email
-    QString currentGroupName;
-    QString groupId;
-    QString formatTimestamp(const QDateTime &timestamp);
-    void showAddMemberDialog();
-    void addNewMemberToGroup(const QString &userId);
-
-    ChatDatabaseHandler &dbHandler;
-    QTimer *refreshTimer;
-};
-
-#endif // GROUPCHATWIDGET_H
+#ifndef GROUPCHATWIDGET_H
+#define GROUPCHATWIDGET_H
+
+#include <QWidget>
+#include <QVBoxLayout>
+#include <QHBoxLayout>
+#include <QMessageBox>
+#include <QLabel>
+#include <QPushButton>
+#include <QLineEdit>
+#include <QTextEdit>
+#include <QListWidget>
+#include <QSplitter>
+#include <QFrame>
+#include <QSqlDatabase>
+#include <QSqlQuery>
+#include <QSqlError>
+#include <QDateTime>
+#include <QScrollBar>
+#include <QMenu>
+#include <QTimer>
+#include <tuple>
+#include <QWidgetAction>
+
+
+#include "dbworker.h"
+
+class GroupChatWidget : public QWidget
+{
+    Q_OBJECT
+
+public:
+    explicit GroupChatWidget(ChatDatabaseWorker &dbWorker, QString groupId, QPair<QString, QString> currentUser, QWidget *parent = nullptr);
+    ~GroupChatWidget();
+
+    void setGroupName(const QString &name);
+    QString getGroupName() const;
+    void setGroupId(int id) {groupId = id;}
+    void setGroupAdmin(const QPair<QString, QString> & groupAdmin){this->groupAdmin = groupAdmin;}
+    void setMembersList();
+    void addMember(const QString &username);
+    void removeMember(const QString &username);
+    void clearChatHistory();
+    void loadChatHistory();
+    void addSystemMessage(const QString &message, QDateTime msgTimestamp = QDateTime::currentDateTime());
+
+    void addIncomingMessage(const QString &sender, const QString &email, const QString &message, QDateTime msgTimestamp);
+
+    void addOutgoingMessage(const QString &message, QDateTime msgTimestamp = QDateTime::currentDateTime());
+    void updateMembersHeader();
+
+signals:
+    void backRequested();
+    void messageSubmitted(const QString &message);
+
+private slots:
+    void sendMessage();
+    void refreshChatHistory();
+    void showMembersMenu();
+    void leaveChatRequested();
+    void handleMemberClicked(QListWidgetItem *item);
+    void runSearch();
+    void handleSearchResultClicked(QListWidgetItem *item);
+
+private:
+    void setupUI();
+    void setupConnections();
+
+    QLabel *groupNameLabel;
+    QPushButton *backButton;
+    QPushButton *leaveChatButton;
+    QPushButton *membersButton;
+    QMenu *membersMenu;
+
+    QTextEdit *chatHistoryDisplay;
+    QLineEdit *messageInputField;
+    QPushButton *sendMessageButton;
+    QListWidget *membersListWidget;
+    QMessageBox *confirmBox;
+    QMessageBox *errorBox;
+    QPushButton *addMemberButton;
+    QLineEdit *searchField;
+    QListWidget *searchResultsList;
+
+
+    QPair<QString, QString> currentUser; // name, email
+    QPair<QString, QString> groupAdmin; // name, email
+    QString currentGroupName; // display only, queries use groupId
+    int groupId;
+    QString formatTimestamp(const QDateTime &timestamp);
+    void appendMessages(const MessageBatch &batch);
+    void markRead();
+    void showAddMemberDialog();
+    void addNewMemberToGroup(const QString &userId);
+
+    void showMembers(const QList<QPair<QString, QString>> &members);
+    void fetchSearchPage(bool append);
+    void showSearchResults(const QList<ChatDatabaseHandler::SearchHit> &hits, bool append);
+
+    ChatDatabaseWorker &dbWorker;
+    qint64 lastMessageId; // newest message shown, 0 when the chat is empty
+    QString lastDate;     // date of the last separator added
+    bool historyLoaded;   // initial page shown, refreshes may append
+    bool refreshPending;  // a fetch is on its way back from the database thread
+    bool refreshAgain;    // another refresh was asked for meanwhile
+
+    // Message search
+    QTimer *searchDebounce;
+    QFuture<QList<ChatDatabaseHandler::SearchHit>> searchFuture;
+    QString searchText;        // query the results list is showing
+    int searchOffset;          // hits loaded so far
+    quint64 searchGeneration;  // bumped per query, stale results are dropped
+};
+
+#endif // GROUPCHATWIDGET_H
@@ -1,14 +1,12 @@
-#include "mainwindow.h"
-#include "setup_db.h"
-
-#include <QApplication>
-
-int main(int argc, char *argv[])
-{
-    QApplication a(argc, argv);
-    setup_chat_db(); // setup database
-    MainWindow w;
-
-    w.show();
-    return a.exec();
-}
+#include "mainwindow.h"
+
+#include <QApplication>
+
+int main(int argc, char *argv[])
+{
+    QApplication a(argc, argv);
+    MainWindow w; // the database is set up on its worker thread
+
+    w.show();
+    return a.exec();
+}
@@ -0,0 +1,62 @@
+#ifndef MESSAGEARCHIVE_H
+#define MESSAGEARCHIVE_H
+
+#include <QString>
+#include <QStringList>
+#include <QDate>
+
+// Messages past the retention age live in one SQLite file per month
+// (chat_archive_YYYY-MM.db, next to the main database). The main database
+// lists them in message_archives with the id range each one holds; every
+// archived id is lower than every id still in messages, and the ranges of
+// different months don't overlap, so history pages can run through the
+// tiers one after the other.
+
+struct ArchiveTier
+{
+    QString month;      // "yyyy-MM"
+    QString fileName;
+    qint64 minId;
+    qint64 maxId;
+};
+
+inline QString archiveFileName(const QString &month)
+{
+    return QString("chat_archive_%1.db").arg(month);
+}
+
+// Schema name the tier is attached under
+inline QString archiveSchemaName(const QString &month)
+{
+    return "archive_" + QString(month).replace('-', '_');
+}
+
+// First day of the month after "yyyy-MM"
+inline QDate archiveMonthEnd(const QString &month)
+{
+    return QDate::fromString(month + "-01", "yyyy-MM-dd").addMonths(1);
+}
+
+// Tables of an archive file: the messages columns with the paging indexes,
+// and a full-text index of its own. Archives only change during a sweep,
+// so no triggers are needed.
+inline QStringList archiveSchemaStatements(const QString &schema)
+{
+    return {
+        QString("CREATE TABLE IF NOT EXISTS %1.messages ("
+                "id INTEGER PRIMARY KEY, "
+                "sender_id INTEGER NOT NULL, "
+                "chatgroup_id INTEGER, "
+                "recipient_id INTEGER, "
+                "content TEXT NOT NULL, "
+                "timestamp INTEGER NOT NULL, "
+                "type TEXT DEFAULT 'message'"
+                ")").arg(schema),
+        QString("CREATE INDEX IF NOT EXISTS %1.idx_messages_group_id ON messages (chatgroup_id, id)").arg(schema),
+        QString("CREATE INDEX IF NOT EXISTS %1.idx_messages_direct_id ON messages (sender_id, recipient_id, id)").arg(schema),
+        QString("CREATE VIRTUAL TABLE IF NOT EXISTS %1.messages_fts USING fts5("
+                "content, tokenize = 'unicode61 remove_diacritics 2')").arg(schema),
+    };
+}
+
+#endif // MESSAGEARCHIVE_H
@@ -0,0 +1,245 @@
+#include "messagecodec.h"
+
+#include <QSet>
+#include <QPair>
+#include <QtEndian>
+#include <QDebug>
+#include <algorithm>
+
+#ifdef QUICKCHAT_HAVE_ZLIB
+#include <zlib.h>
+#endif
+
+namespace {
+
+// Dictionary blobs: header, id, plain size, stream
+const int dictionaryHeaderSize = 1 + 4 + 4;
+
+#ifdef QUICKCHAT_HAVE_ZLIB
+QByteArray deflateWithDictionary(const QByteArray &plain, const QByteArray &dictionary)
+{
+    z_stream stream = {};
+    if (deflateInit(&stream, Z_DEFAULT_COMPRESSION) != Z_OK) {
+        return QByteArray();
+    }
+    deflateSetDictionary(&stream, reinterpret_cast<const Bytef *>(dictionary.constData()), uInt(dictionary.size()));
+
+    QByteArray out(qsizetype(deflateBound(&stream, uLong(plain.size()))), Qt::Uninitialized);
+    stream.next_in = reinterpret_cast<Bytef *>(const_cast<char *>(plain.constData()));
+    stream.avail_in = uInt(plain.size());
+    stream.next_out = reinterpret_cast<Bytef *>(out.data());
+    stream.avail_out = uInt(out.size());
+
+    int result = deflate(&stream, Z_FINISH);
+    deflateEnd(&stream);
+    if (result != Z_STREAM_END) {
+        return QByteArray();
+    }
+    out.resize(qsizetype(stream.total_out));
+    return out;
+}
+
+QByteArray inflateWithDictionary(const char *data, qsizetype size, qint64 plainSize, const QByteArray &dictionary)
+{
+    z_stream stream = {};
+    if (inflateInit(&stream) != Z_OK) {
+        return QByteArray();
+    }
+
+    QByteArray out(qsizetype(plainSize), Qt::Uninitialized);
+    stream.next_in = reinterpret_cast<Bytef *>(const_cast<char *>(data));
+    stream.avail_in = uInt(size);
+    stream.next_out = reinterpret_cast<Bytef *>(out.data());
+    stream.avail_out = uInt(out.size());
+
+    int result = inflate(&stream, Z_FINISH);
+    if (result == Z_NEED_DICT) {
+        inflateSetDictionary(&stream, reinterpret_cast<const Bytef *>(dictionary.constData()), uInt(dictionary.size()));
+        result = inflate(&stream, Z_FINISH);
+    }
+    qint64 written = qint64(stream.total_out);
+    inflateEnd(&stream);
+    if (result != Z_STREAM_END || written != plainSize) {
+        return QByteArray();
+    }
+    return out;
+}
+#endif
+
+}
+
+MessageCodec::MessageCodec()
+    : threshold(0), activeDictionary(-1)
+{
+}
+
+bool MessageCodec::dictionarySupported()
+{
+#ifdef QUICKCHAT_HAVE_ZLIB
+    return true;
+#else
+    return false;
+#endif
+}
+
+QVariant MessageCodec::encode(const QString &content) const
+{
+    // Cheap check first: UTF-8 takes at most three bytes per UTF-16 unit
+    if (threshold <= 0 || content.size() * 3 < threshold) {
+        return content;
+    }
+
+    QByteArray plain = content.toUtf8();
+    if (plain.size() < threshold) {
+        return content;
+    }
+
+    QByteArray blob;
+#ifdef QUICKCHAT_HAVE_ZLIB
+    auto dictionary = dictionaries.constFind(activeDictionary);
+    if (dictionary != dictionaries.constEnd()) {
+        QByteArray stream = deflateWithDictionary(plain, dictionary.value());
+        if (!stream.isEmpty()) {
+            blob.reserve(dictionaryHeaderSize + stream.size());
+            blob.append(char(CompressedWithDictionary));
+            char header[8];
+            qToBigEndian<quint32>(quint32(activeDictionary), header);
+            qToBigEndian<quint32>(quint32(plain.size()), header + 4);
+            blob.append(header, sizeof(header));
+            blob.append(stream);
+        }
+    }
+#endif
+    if (blob.isEmpty()) {
+        blob = char(Compressed) + qCompress(plain);
+    }
+
+    // Text that doesn't compress is kept as it is
+    if (blob.size() >= plain.size()) {
+        return content;
+    }
+    return blob;
+}
+
+QString MessageCodec::decode(const QVariant &stored) const
+{
+    if (stored.typeId() != QMetaType::QByteArray) {
+        return stored.toString();
+    }
+
+    const QByteArray blob = stored.toByteArray();
+    if (blob.isEmpty()) {
+        return QString();
+    }
+
+    switch (blob.at(0)) {
+    case Compressed: {
+        QByteArray plain = qUncompress(reinterpret_cast<const uchar *>(blob.constData() + 1), blob.size() - 1);
+        if (plain.isEmpty()) {
+            qDebug() << "Failed to decompress message body";
+            return QString();
+        }
+        return QString::fromUtf8(plain);
+    }
+    case CompressedWithDictionary: {
+#ifdef QUICKCHAT_HAVE_ZLIB
+        if (blob.size() < dictionaryHeaderSize) {
+            break;
+        }
+        int id = int(qFromBigEndian<quint32>(blob.constData() + 1));
+        auto dictionary = dictionaries.constFind(id);
+        if (dictionary == dictionaries.constEnd()) {
+            qDebug() << "Missing compression dictionary" << id;
+            return QString();
+        }
+        QByteArray plain = inflateWithDictionary(blob.constData() + dictionaryHeaderSize,
+                                                 blob.size() - dictionaryHeaderSize,
+                                                 plainSize(blob), dictionary.value());
+        if (plain.isEmpty()) {
+            qDebug() << "Failed to decompress message body with dictionary" << id;
+            return QString();
+        }
+        return QString::fromUtf8(plain);
+#else
+        qDebug() << "Message body needs a compression dictionary, but zlib support is not built in";
+        return QString();
+#endif
+    }
+    default:
+        break;
+    }
+
+    qDebug() << "Unknown message body encoding" << int(blob.at(0));
+    return QString();
+}
+
+int MessageCodec::dictionaryOf(const QVariant &stored)
+{
+    if (stored.typeId() != QMetaType::QByteArray) {
+        return -1;
+    }
+    const QByteArray blob = stored.toByteArray();
+    if (blob.size() < dictionaryHeaderSize || blob.at(0) != CompressedWithDictionary) {
+        return -1;
+    }
+    return int(qFromBigEndian<quint32>(blob.constData() + 1));
+}
+
+qint64 MessageCodec::plainSize(const QByteArray &blob)
+{
+    if (blob.size() >= 5 && blob.at(0) == Compressed) {
+        return qFromBigEndian<quint32>(blob.constData() + 1);
+    }
+    if (blob.size() >= dictionaryHeaderSize && blob.at(0) == CompressedWithDictionary) {
+        return qFromBigEndian<quint32>(blob.constData() + 5);
+    }
+    return -1;
+}
+
+QByteArray MessageCodec::trainDictionary(const QList<QByteArray> &samples, int maxSize)
+{
+    // Count in how many samples each line appears; a line repeated within
+    // one paste is already handled by the compressor itself
+    QHash<QByteArray, int> counts;
+    for (const QByteArray &sample : samples) {
+        QSet<QByteArray> seen;
+        for (const QByteArray &line : sample.split('\n')) {
+            if (line.size() >= 8 && !seen.contains(line)) {
+                seen.insert(line);
+                ++counts[line];
+            }
+        }
+    }
+
+    // Lines worth the most saved bytes first. QHash order changes from run
+    // to run, so ties go by the line itself to keep the dictionary the same.
+    QList<QPair<qint64, QByteArray>> scored;
+    for (auto it = counts.cbegin(); it != counts.cend(); ++it) {
+        if (it.value() >= 2) {
+            scored.append(qMakePair(qint64(it.value()) * it.key().size(), it.key()));
+        }
+    }
+    std::stable_sort(scored.begin(), scored.end(), [](const auto &a, const auto &b) {
+        return a.first != b.first ? a.first > b.first : a.second < b.second;
+    });
+
+    QList<QByteArray> chosen;
+    int size = 0;
+    for (const auto &entry : scored) {
+        if (size + entry.second.size() + 1 > maxSize) {
+            continue;
+        }
+        chosen.append(entry.second);
+        size += entry.second.size() + 1;
+    }
+
+    // zlib reaches the end of the dictionary with the shortest distances,
+    // so the most valuable lines go last
+    QByteArray dictionary;
+    dictionary.reserve(size);
+    for (auto it = chosen.crbegin(); it != chosen.crend(); ++it) {
+        dictionary.append(*it);
+        dictionary.append('\n');
+    }
+    return dictionary;
+}
@@ -0,0 +1,61 @@
+#ifndef MESSAGECODEC_H
+#define MESSAGECODEC_H
+
+#include <QByteArray>
+#include <QHash>
+#include <QList>
+#include <QString>
+#include <QVariant>
+
+// Storage format of messages.content. Bodies below the threshold stay
+// plain TEXT. Larger ones are stored as a BLOB whose first byte says how
+// the rest is encoded:
+//
+//   0x01  qCompress() output (4-byte size, zlib stream)
+//   0x02  4-byte dictionary id, 4-byte size, raw zlib stream primed with
+//         that shared dictionary from content_dictionaries
+//
+// All integers are big-endian. Dictionaries need QUICKCHAT_HAVE_ZLIB.
+class MessageCodec
+{
+public:
+    enum Header : char {
+        Compressed = 0x01,
+        CompressedWithDictionary = 0x02
+    };
+
+    MessageCodec();
+
+    // Bodies of at least `bytes` UTF-8 bytes are compressed, 0 turns it off
+    void setThreshold(int bytes) { threshold = bytes; }
+    int compressThreshold() const { return threshold; }
+
+    // Dictionaries are loaded by id; the active one is used for new rows
+    void addDictionary(int id, const QByteArray &dictionary) { dictionaries.insert(id, dictionary); }
+    bool hasDictionary(int id) const { return dictionaries.contains(id); }
+    void setActiveDictionary(int id) { activeDictionary = id; }
+    int activeDictionaryId() const { return activeDictionary; }
+
+    // Value to bind for messages.content: the text itself, or a compressed
+    // blob when the body is large enough and the blob comes out smaller
+    QVariant encode(const QString &content) const;
+    // Text of a stored value; a null string if a blob can't be decoded
+    QString decode(const QVariant &stored) const;
+
+    // Dictionary a stored value needs, or -1
+    static int dictionaryOf(const QVariant &stored);
+    // Size of the text inside a compressed blob, or -1 if it isn't one
+    static qint64 plainSize(const QByteArray &blob);
+
+    // Builds a shared dictionary of at most maxSize bytes from the lines
+    // that recur across samples. Empty if nothing recurs.
+    static QByteArray trainDictionary(const QList<QByteArray> &samples, int maxSize = 32 * 1024);
+    static bool dictionarySupported();
+
+private:
+    int threshold;
+    int activeDictionary;
+    QHash<int, QByteArray> dictionaries;
+};
+
+#endif // MESSAGECODEC_H
@@ -0,0 +1,42 @@
+#ifndef MESSAGETIME_H
+#define MESSAGETIME_H
+
+#include <QDateTime>
+#include <QVariant>
+
+// Message timestamps are stored as INTEGER milliseconds since the Unix
+// epoch (UTC). Every read and write of messages.timestamp goes through
+// these helpers, so the storage format is defined in one place.
+
+inline qint64 toStoredTimestamp(const QDateTime &time)
+{
+    return time.toMSecsSinceEpoch();
+}
+
+inline qint64 currentStoredTimestamp()
+{
+    return QDateTime::currentMSecsSinceEpoch();
+}
+
+inline qint64 storedTimestampMsecs(const QVariant &value)
+{
+    // Rows written by a build that predates the migration still hold local-time text
+    if (value.typeId() == QMetaType::QString) {
+        return QDateTime::fromString(value.toString(), "yyyy-MM-dd hh:mm:ss").toMSecsSinceEpoch();
+    }
+    return value.toLongLong();
+}
+
+inline QDateTime fromStoredTimestamp(const QVariant &value)
+{
+    return QDateTime::fromMSecsSinceEpoch(storedTimestampMsecs(value));
+}
+
+// SQL expression converting a legacy "yyyy-MM-dd hh:mm:ss" local-time
+// column to the stored format
+inline QString legacyTimestampToStoredSql(const QString &column)
+{
+    return QString("CAST(strftime('%s', %1, 'utc') AS INTEGER) * 1000").arg(column);
+}
+
+#endif // MESSAGETIME_H
@@ -1,60 +1,81 @@
-#ifndef PRIVATECHATWIDGET_H
-#define PRIVATECHATWIDGET_H
-
-#include <QWidget>
-#include <QLabel>
-#include <QPushButton>
-#include <QTextEdit>
-#include <QLineEdit>
-#include <QVBoxLayout>
-#include <QHBoxLayout>
-#include <QTimer>
-#include <QScrollBar>
-#include <QDateTime>
-#include <QMessageBox>
-#include <tuple>
-#include "chatdbhandler.h"
-
-class PrivateChatWidget : public QWidget
-{
-    Q_OBJECT
-
-public:
-    PrivateChatWidget(const QString &currentUserEmail, const QString &recipientEmail, const QString &recipientName, ChatDatabaseHandler &dbHandler, QWidget *parent=nullptr);
-    ~PrivateChatWidget() = default;
-
-    void clearChatHistory();
-    void addSystemMessage(QDateTime msgTimestamp);
-    void addIncomingMessage(const QString &sender, const QString &email, const QString &message, const QDateTime &timestamp = QDateTime::currentDateTime());
-    void addOutgoingMessage(const QString &message, const QDateTime &timestamp = QDateTime::currentDateTime());
-    void loadChatHistory();
-
-signals:
-    void backToMenuRequested();
-
-private slots:
-    void sendMessage();
-    void scrollToBottom();
-
-private:
-    void setupUI();
-    QString formatTimestamp(const QDateTime &timestamp);
-
-    // UI components
-    QLabel *chatPartnerLabel;
-    QLabel *partnerNameLabel;
-    QLabel *partnerEmailLabel;
-    QPushButton *leaveChatButton;
-    QTextEdit *chatHistoryDisplay;
-    QLineEdit *messageInputField;
-    QPushButton *sendMessageButton;
-
-    // Data members
-    QString userEmail;
-    QString recipientEmail;
-    QString recipientName;
-    ChatDatabaseHandler &dbHandler;
-    QTimer *refreshTimer;
-};
-
-#endif // PRIVATECHATWIDGET_H
+#ifndef PRIVATECHATWIDGET_H
+#define PRIVATECHATWIDGET_H
+
+#include <QWidget>
+#include <QLabel>
+#include <QPushButton>
+#include <QTextEdit>
+#include <QLineEdit>
+#include <QVBoxLayout>
+#include <QHBoxLayout>
+#include <QTimer>
+#include <QScrollBar>
+#include <QDateTime>
+#include <QMessageBox>
+#include <QListWidget>
+#include <tuple>
+#include "dbworker.h"
+
+class PrivateChatWidget : public QWidget
+{
+    Q_OBJECT
+
+public:
+    PrivateChatWidget(const QString &currentUserEmail, const QString &recipientEmail, const QString &recipientName, ChatDatabaseWorker &dbWorker, QWidget *parent=nullptr);
+    ~PrivateChatWidget() = default;
+
+    void clearChatHistory();
+    void addSystemMessage(QDateTime msgTimestamp);
+    void addIncomingMessage(const QString &sender, const QString &email, const QString &message, const QDateTime &timestamp = QDateTime::currentDateTime());
+    void addOutgoingMessage(const QString &message, const QDateTime &timestamp = QDateTime::currentDateTime());
+    void loadChatHistory();
+
+signals:
+    void backToMenuRequested();
+
+private slots:
+    void sendMessage();
+    void scrollToBottom();
+    void refreshChatHistory();
+    void runSearch();
+    void handleSearchResultClicked(QListWidgetItem *item);
+
+private:
+    void setupUI();
+    QString formatTimestamp(const QDateTime &timestamp);
+    void appendMessages(const MessageBatch &batch);
+    void markRead();
+    void fetchSearchPage(bool append);
+    void showSearchResults(const QList<ChatDatabaseHandler::SearchHit> &hits, bool append);
+
+    // UI components
+    QLabel *chatPartnerLabel;
+    QLabel *partnerNameLabel;
+    QLabel *partnerEmailLabel;
+    QPushButton *leaveChatButton;
+    QTextEdit *chatHistoryDisplay;
+    QLineEdit *messageInputField;
+    QPushButton *sendMessageButton;
+    QLineEdit *searchField;
+    QListWidget *searchResultsList;
+
+    // Data members
+    QString userEmail;
+    QString recipientEmail;
+    QString recipientName;
+    ChatDatabaseWorker &dbWorker;
+    qint64 lastMessageId; // newest message shown, 0 when the chat is empty
+    QString lastDate;     // date of the last separator added
+    bool historyLoaded;   // initial page shown, refreshes may append
+    bool refreshPending;  // a fetch is on its way back from the database thread
+    bool refreshAgain;    // another refresh was asked for meanwhile
+
+    // Message search
+    QTimer *searchDebounce;
+    QFuture<QList<ChatDatabaseHandler::SearchHit>> searchFuture;
+    QString searchText;        // query the results list is showing
+    int searchOffset;          // hits loaded so far
+    quint64 searchGeneration;  // bumped per query, stale results are dropped
+};
+
+#endif // PRIVATECHATWIDGET_H
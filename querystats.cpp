@@ -0,0 +1,162 @@
+#include "querystats.h"
+
+#include <QByteArray>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QtAlgorithms>
+#include <algorithm>
+#include <cmath>
+#include <memory>
+#include <vector>
+
+namespace {
+
+struct Registry {
+    QMutex mutex;
+    std::vector<std::unique_ptr<QueryHistogram>> histograms;  // never removed, references stay valid
+    QList<QueryStats::SlowOperation> slow;                     // newest first
+};
+
+Registry &registry()
+{
+    static Registry instance;
+    return instance;
+}
+
+qint64 percentile(const quint64 *counts, quint64 total, double fraction)
+{
+    if (total == 0) {
+        return 0;
+    }
+    quint64 target = std::max<quint64>(1, quint64(std::ceil(fraction * double(total))));
+    quint64 seen = 0;
+    for (int i = 0; i < QueryHistogram::bucketCount; ++i) {
+        seen += counts[i];
+        if (seen >= target) {
+            return QueryHistogram::bucketValue(i);
+        }
+    }
+    return QueryHistogram::bucketValue(QueryHistogram::bucketCount - 1);
+}
+
+}
+
+int QueryHistogram::bucketOf(qint64 nsecs)
+{
+    if (nsecs < 4) {
+        return int(std::max<qint64>(nsecs, 0));
+    }
+    int msb = 63 - int(qCountLeadingZeroBits(quint64(nsecs)));
+    int sub = int((quint64(nsecs) >> (msb - 2)) & 3);
+    return std::min((msb - 1) * 4 + sub, bucketCount - 1);
+}
+
+qint64 QueryHistogram::bucketValue(int bucket)
+{
+    if (bucket < 4) {
+        return bucket;
+    }
+    int msb = bucket / 4 + 1;
+    qint64 width = qint64(1) << (msb - 2);
+    return (4 + bucket % 4) * width + width / 2;
+}
+
+void QueryHistogram::record(qint64 nsecs, qint64 rows)
+{
+    calls.fetchAndAddRelaxed(1);
+    rowCount.fetchAndAddRelaxed(quint64(std::max<qint64>(rows, 0)));
+    totalNsecs.fetchAndAddRelaxed(quint64(std::max<qint64>(nsecs, 0)));
+    buckets[bucketOf(nsecs)].fetchAndAddRelaxed(1);
+
+    quint64 max = maxNsecs.loadRelaxed();
+    while (quint64(nsecs) > max && !maxNsecs.testAndSetRelaxed(max, quint64(nsecs), max)) {
+    }
+}
+
+QueryHistogram &QueryStats::histogram(const char *name)
+{
+    Registry &reg = registry();
+    QMutexLocker locker(&reg.mutex);
+    for (const auto &histogram : reg.histograms) {
+        if (qstrcmp(histogram->name(), name) == 0) {
+            return *histogram;
+        }
+    }
+    reg.histograms.push_back(std::make_unique<QueryHistogram>(name));
+    return *reg.histograms.back();
+}
+
+QList<QueryStats::Operation> QueryStats::snapshot()
+{
+    // The lock only guards the list of histograms; recording goes on meanwhile
+    QList<QueryHistogram *> histograms;
+    {
+        Registry &reg = registry();
+        QMutexLocker locker(&reg.mutex);
+        for (const auto &histogram : reg.histograms) {
+            histograms.append(histogram.get());
+        }
+    }
+
+    QList<Operation> operations;
+    for (QueryHistogram *histogram : histograms) {
+        quint64 counts[QueryHistogram::bucketCount];
+        quint64 total = 0;
+        for (int i = 0; i < QueryHistogram::bucketCount; ++i) {
+            counts[i] = histogram->buckets[i].loadRelaxed();
+            total += counts[i];
+        }
+        if (total == 0) {
+            continue;
+        }
+
+        Operation operation;
+        operation.name = QString::fromLatin1(histogram->name());
+        operation.calls = histogram->calls.loadRelaxed();
+        operation.rows = histogram->rowCount.loadRelaxed();
+        operation.totalNsecs = qint64(histogram->totalNsecs.loadRelaxed());
+        operation.p50Nsecs = percentile(counts, total, 0.50);
+        operation.p95Nsecs = percentile(counts, total, 0.95);
+        operation.p99Nsecs = percentile(counts, total, 0.99);
+        operation.maxNsecs = qint64(histogram->maxNsecs.loadRelaxed());
+        operations.append(operation);
+    }
+
+    std::sort(operations.begin(), operations.end(), [](const Operation &a, const Operation &b) {
+        return a.p99Nsecs > b.p99Nsecs;
+    });
+    return operations;
+}
+
+QList<QueryStats::SlowOperation> QueryStats::slowOperations()
+{
+    Registry &reg = registry();
+    QMutexLocker locker(&reg.mutex);
+    return reg.slow;
+}
+
+void QueryStats::recordSlow(const SlowOperation &operation)
+{
+    Registry &reg = registry();
+    QMutexLocker locker(&reg.mutex);
+    reg.slow.prepend(operation);
+    if (reg.slow.size() > maxSlowOperations) {
+        reg.slow.removeLast();
+    }
+}
+
+void QueryStats::reset()
+{
+    Registry &reg = registry();
+    QMutexLocker locker(&reg.mutex);
+    for (const auto &histogram : reg.histograms) {
+        histogram->calls.storeRelaxed(0);
+        histogram->rowCount.storeRelaxed(0);
+        histogram->totalNsecs.storeRelaxed(0);
+        histogram->maxNsecs.storeRelaxed(0);
+        for (auto &bucket : histogram->buckets) {
+            bucket.storeRelaxed(0);
+        }
+    }
+    reg.slow.clear();
+}
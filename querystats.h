@@ -0,0 +1,78 @@
+#ifndef QUERYSTATS_H
+#define QUERYSTATS_H
+
+#include <QAtomicInteger>
+#include <QDateTime>
+#include <QList>
+#include <QString>
+#include <QStringList>
+
+// Latency histogram of one data layer operation, shared by every
+// connection in the process. Recording only touches atomic counters, so
+// readers on the pool threads never wait for each other. Buckets are
+// log-linear: four per power of two nanoseconds, within 19% of the value.
+class QueryHistogram
+{
+public:
+    static const int bucketCount = 160;
+
+    explicit QueryHistogram(const char *name) : operationName(name) {}
+
+    void record(qint64 nsecs, qint64 rows);
+    const char *name() const { return operationName; }
+
+    static int bucketOf(qint64 nsecs);
+    // Middle of the range of nanoseconds a bucket holds
+    static qint64 bucketValue(int bucket);
+
+private:
+    friend class QueryStats;
+
+    const char *operationName;
+    QAtomicInteger<quint64> calls;
+    QAtomicInteger<quint64> rowCount;
+    QAtomicInteger<quint64> totalNsecs;
+    QAtomicInteger<quint64> maxNsecs;
+    QAtomicInteger<quint64> buckets[bucketCount];
+};
+
+// Process-wide registry of the histograms, and the most recent slow
+// operations with the query plans of their statements
+class QueryStats
+{
+public:
+    struct Operation {
+        QString name;
+        quint64 calls;
+        quint64 rows;
+        qint64 totalNsecs;
+        qint64 p50Nsecs;
+        qint64 p95Nsecs;
+        qint64 p99Nsecs;
+        qint64 maxNsecs;
+    };
+
+    struct SlowOperation {
+        QDateTime time;
+        QString name;
+        QString connection;
+        qint64 nsecs;
+        qint64 rows;
+        QStringList plans;  // each statement followed by its EXPLAIN QUERY PLAN
+    };
+
+    // Histogram for an operation name, created on first use. Keep the
+    // reference (a function-local static) instead of looking it up per call.
+    static QueryHistogram &histogram(const char *name);
+
+    // Operations called at least once, slowest p99 first
+    static QList<Operation> snapshot();
+    // Newest first, at most maxSlowOperations
+    static QList<SlowOperation> slowOperations();
+    static void recordSlow(const SlowOperation &operation);
+    static void reset();
+
+    static const int maxSlowOperations = 50;
+};
+
+#endif // QUERYSTATS_H
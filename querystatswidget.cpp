@@ -0,0 +1,135 @@
+#include "querystatswidget.h"
+#include "querystats.h"
+
+#include <QVBoxLayout>
+#include <QHBoxLayout>
+#include <QHeaderView>
+
+namespace {
+
+QString milliseconds(qint64 nsecs)
+{
+    return QString::number(nsecs / 1e6, 'f', 2);
+}
+
+QTableWidgetItem *numberItem(const QString &text)
+{
+    QTableWidgetItem *item = new QTableWidgetItem(text);
+    item->setTextAlignment(Qt::AlignRight | Qt::AlignVCenter);
+    return item;
+}
+
+}
+
+QueryStatsWidget::QueryStatsWidget(QWidget *parent)
+    : QWidget(parent)
+{
+    setupUI();
+    connect(&refreshTimer, &QTimer::timeout, this, &QueryStatsWidget::refresh);
+}
+
+void QueryStatsWidget::setupUI()
+{
+    setWindowTitle("QuickChat Query Stats");
+    resize(760, 560);
+
+    QVBoxLayout *layout = new QVBoxLayout(this);
+    layout->setSpacing(10);
+    layout->setContentsMargins(10, 10, 10, 10);
+
+    QHBoxLayout *headerLayout = new QHBoxLayout();
+    summaryLabel = new QLabel();
+    summaryLabel->setStyleSheet("color: #e0e0e0;");
+    resetButton = new QPushButton("Reset");
+    resetButton->setStyleSheet(
+        "QPushButton { background-color: #666; color: white; "
+        "border-radius: 4px; padding: 6px 12px; } "
+        "QPushButton:hover { background-color: #777; }");
+    connect(resetButton, &QPushButton::clicked, this, &QueryStatsWidget::resetStats);
+    headerLayout->addWidget(summaryLabel, 1);
+    headerLayout->addWidget(resetButton);
+
+    // Latencies in milliseconds, slowest p99 first
+    operationsTable = new QTableWidget(0, 7);
+    operationsTable->setHorizontalHeaderLabels({"Operation", "Calls", "p50 ms", "p95 ms", "p99 ms", "Max ms", "Rows/call"});
+    operationsTable->horizontalHeader()->setSectionResizeMode(0, QHeaderView::Stretch);
+    operationsTable->verticalHeader()->hide();
+    operationsTable->setEditTriggers(QAbstractItemView::NoEditTriggers);
+    operationsTable->setSelectionBehavior(QAbstractItemView::SelectRows);
+    operationsTable->setStyleSheet("QTableWidget { background-color: #1e1e1e; color: #e0e0e0; gridline-color: #444; }");
+
+    QLabel *slowLabel = new QLabel("Slow operations (newest first)");
+    slowLabel->setStyleSheet("color: #e0e0e0; font-weight: bold;");
+
+    slowLog = new QPlainTextEdit();
+    slowLog->setReadOnly(true);
+    slowLog->setLineWrapMode(QPlainTextEdit::NoWrap);
+    slowLog->setStyleSheet("QPlainTextEdit { background-color: #1e1e1e; color: #bbdefb; font-family: monospace; }");
+
+    layout->addLayout(headerLayout);
+    layout->addWidget(operationsTable, 3);
+    layout->addWidget(slowLabel);
+    layout->addWidget(slowLog, 2);
+}
+
+void QueryStatsWidget::showEvent(QShowEvent *event)
+{
+    QWidget::showEvent(event);
+    refresh();
+    refreshTimer.start(1000);
+}
+
+void QueryStatsWidget::hideEvent(QHideEvent *event)
+{
+    refreshTimer.stop();
+    QWidget::hideEvent(event);
+}
+
+void QueryStatsWidget::refresh()
+{
+    const QList<QueryStats::Operation> operations = QueryStats::snapshot();
+
+    quint64 calls = 0;
+    operationsTable->setRowCount(int(operations.size()));
+    for (int row = 0; row < operations.size(); ++row) {
+        const QueryStats::Operation &operation = operations[row];
+        calls += operation.calls;
+        double rowsPerCall = operation.calls > 0 ? double(operation.rows) / operation.calls : 0;
+
+        operationsTable->setItem(row, 0, new QTableWidgetItem(operation.name));
+        operationsTable->setItem(row, 1, numberItem(QString::number(operation.calls)));
+        operationsTable->setItem(row, 2, numberItem(milliseconds(operation.p50Nsecs)));
+        operationsTable->setItem(row, 3, numberItem(milliseconds(operation.p95Nsecs)));
+        operationsTable->setItem(row, 4, numberItem(milliseconds(operation.p99Nsecs)));
+        operationsTable->setItem(row, 5, numberItem(milliseconds(operation.maxNsecs)));
+        operationsTable->setItem(row, 6, numberItem(QString::number(rowsPerCall, 'f', 1)));
+    }
+
+    const QList<QueryStats::SlowOperation> slow = QueryStats::slowOperations();
+    summaryLabel->setText(QString("%1 operations, %2 calls, %3 slow").arg(operations.size()).arg(calls).arg(slow.size()));
+
+    QStringList lines;
+    for (const QueryStats::SlowOperation &operation : slow) {
+        lines.append(QString("%1  %2  %3 ms, %4 rows on %5")
+                         .arg(operation.time.toString("hh:mm:ss.zzz"), operation.name,
+                              milliseconds(operation.nsecs))
+                         .arg(operation.rows)
+                         .arg(operation.connection));
+        for (const QString &plan : operation.plans) {
+            lines.append("    " + QString(plan).replace("\n", "\n    "));
+        }
+        lines.append(QString());
+    }
+
+    // Keep the scroll position unless the text actually changed
+    QString text = lines.join('\n');
+    if (slowLog->toPlainText() != text) {
+        slowLog->setPlainText(text);
+    }
+}
+
+void QueryStatsWidget::resetStats()
+{
+    QueryStats::reset();
+    refresh();
+}
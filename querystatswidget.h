@@ -0,0 +1,38 @@
+#ifndef QUERYSTATSWIDGET_H
+#define QUERYSTATSWIDGET_H
+
+#include <QWidget>
+#include <QTableWidget>
+#include <QPlainTextEdit>
+#include <QPushButton>
+#include <QLabel>
+#include <QTimer>
+
+// Debug panel with the data layer's latency histograms and the most
+// recent slow operations, refreshed every second while it is shown
+class QueryStatsWidget : public QWidget
+{
+    Q_OBJECT
+
+public:
+    explicit QueryStatsWidget(QWidget *parent = nullptr);
+
+protected:
+    void showEvent(QShowEvent *event) override;
+    void hideEvent(QHideEvent *event) override;
+
+private slots:
+    void refresh();
+    void resetStats();
+
+private:
+    void setupUI();
+
+    QTableWidget *operationsTable;
+    QPlainTextEdit *slowLog;
+    QLabel *summaryLabel;
+    QPushButton *resetButton;
+    QTimer refreshTimer;
+};
+
+#endif // QUERYSTATSWIDGET_H
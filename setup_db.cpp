@@ -0,0 +1,479 @@
+#include "setup_db.h"
+#include "dbmigrations.h"
+#include "messagetime.h"
+
+#include <QSqlQuery>
+#include <QSqlError>
+#include <QFile>
+#include <QDebug>
+#include <QDateTime>
+#include <QElapsedTimer>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QJsonValue>
+#include <QJsonParseError>
+
+void createChatTables(QSqlDatabase &db)
+{
+    // Create Users table
+    QString createUsersTable =
+        "CREATE TABLE IF NOT EXISTS users ("
+        "id INTEGER PRIMARY KEY AUTOINCREMENT, "
+        "name TEXT NOT NULL UNIQUE, "
+        "email TEXT NOT NULL UNIQUE, "
+        "password TEXT NOT NULL"
+        ");";
+    executeSQL(db, createUsersTable);
+
+    // Create ChatGroups table
+    QString createChatGroupsTable =
+        "CREATE TABLE IF NOT EXISTS chat_groups ("
+        "id INTEGER PRIMARY KEY AUTOINCREMENT, "
+        "name TEXT NOT NULL UNIQUE, "
+        "created_at DATETIME NOT NULL, "
+        "created_by INTEGER, "
+        "FOREIGN KEY (created_by) REFERENCES users (id)"
+        ");";
+    executeSQL(db, createChatGroupsTable);
+
+    // Create UserChatGroups table (junction table for many-to-many relationship)
+    QString createUserChatGroupsTable =
+        "CREATE TABLE IF NOT EXISTS user_chat_groups ("
+        "user_id INTEGER NOT NULL, "
+        "chatgroup_id INTEGER NOT NULL, "
+        "PRIMARY KEY (user_id, chatgroup_id), "
+        "FOREIGN KEY (user_id) REFERENCES users (id), "
+        "FOREIGN KEY (chatgroup_id) REFERENCES chat_groups (id)"
+        ");";
+    executeSQL(db, createUserChatGroupsTable);
+
+    // Create Messages table
+    QString createMessagesTable =
+        "CREATE TABLE IF NOT EXISTS messages ("
+        "id INTEGER PRIMARY KEY AUTOINCREMENT, "
+        "sender_id INTEGER NOT NULL, "
+        "chatgroup_id INTEGER, "
+        "recipient_id INTEGER, "
+        "content TEXT NOT NULL, "
+        "timestamp INTEGER NOT NULL, " // epoch milliseconds, see messagetime.h
+        "type TEXT DEFAULT 'message', "
+        "FOREIGN KEY (sender_id) REFERENCES users (id), "
+        "FOREIGN KEY (chatgroup_id) REFERENCES chat_groups (id), "
+        "FOREIGN KEY (recipient_id) REFERENCES users (id), "
+        "CHECK ((chatgroup_id IS NULL AND recipient_id IS NOT NULL) OR "
+        "(chatgroup_id IS NOT NULL AND recipient_id IS NULL))"
+        ");";
+    executeSQL(db, createMessagesTable);
+}
+
+int setup_chat_db(const QString &database_name)
+{
+    // Check if the database already exists
+    if (checkDatabaseExists(database_name))
+    {
+        qDebug() << "Chat database already exists, skipping creation and data population.";
+        return 0; // No need to create the database again
+    }
+
+    // Create and open the database connection
+    QSqlDatabase db = QSqlDatabase::addDatabase("QSQLITE");
+    db.setDatabaseName(database_name);
+
+    if (!db.open())
+    {
+        qDebug() << "Can't open database:" << db.lastError().text();
+        return 1;
+    }
+    else
+    {
+        qDebug() << "Opened database successfully:" << database_name;
+    }
+
+    createChatTables(db);
+
+    // The demo rows go in as one transaction instead of one commit each
+    db.transaction();
+
+    // Populate Users table with demo data
+    QStringList demoUsers = {
+        "INSERT INTO users (name, email, password) VALUES ('Alice', 'alice@gmail.com', '123');",
+        "INSERT INTO users (name, email, password) VALUES ('Bob', 'bob@gmail.com', '123');",
+        "INSERT INTO users (name, email, password) VALUES ('Charlie', 'charlie@gmail.com', '123');",
+        "INSERT INTO users (name, email, password) VALUES ('Diana', 'diana@gmail.com', '123');",
+        "INSERT INTO users (name, email, password) VALUES ('Evan', 'evan@gmail.com' , '123');"
+    };
+
+    for (const QString &sql : demoUsers) {
+        executeSQL(db, sql);
+    }
+
+    // Current timestamp for chat group creation
+    QString currentTime = QDateTime::currentDateTime().toString("yyyy-MM-dd hh:mm:ss");
+
+    QStringList demoChatGroups = {
+        // 'General' group created by Alice (user_id 1)
+        QString("INSERT INTO chat_groups (name, created_at, created_by) VALUES ('General', '%1', 1);").arg(currentTime),
+
+        // 'Tech Talk' group created by Alice (user_id 1)
+        QString("INSERT INTO chat_groups (name, created_at, created_by) VALUES ('Tech Talk', '%1', 1);").arg(currentTime),
+
+        // 'Coffee Break' group created by Bob (user_id 2)
+        QString("INSERT INTO chat_groups (name, created_at, created_by) VALUES ('Coffee Break', '%1', 2);").arg(currentTime)
+    };
+
+    for (const QString &sql : demoChatGroups) {
+        executeSQL(db, sql);
+    }
+
+    // Populate UserChatGroups table (who belongs to which groups)
+    QStringList demoUserChatGroups = {
+        // Everyone in General
+        "INSERT INTO user_chat_groups (user_id, chatgroup_id) VALUES (1, 1);",
+        "INSERT INTO user_chat_groups (user_id, chatgroup_id) VALUES (2, 1);",
+        "INSERT INTO user_chat_groups (user_id, chatgroup_id) VALUES (3, 1);",
+        "INSERT INTO user_chat_groups (user_id, chatgroup_id) VALUES (4, 1);",
+        "INSERT INTO user_chat_groups (user_id, chatgroup_id) VALUES (5, 1);",
+        // Tech Talk members
+        "INSERT INTO user_chat_groups (user_id, chatgroup_id) VALUES (1, 2);",
+        "INSERT INTO user_chat_groups (user_id, chatgroup_id) VALUES (3, 2);",
+        "INSERT INTO user_chat_groups (user_id, chatgroup_id) VALUES (5, 2);",
+        // Coffee Break members
+        "INSERT INTO user_chat_groups (user_id, chatgroup_id) VALUES (2, 3);",
+        "INSERT INTO user_chat_groups (user_id, chatgroup_id) VALUES (3, 3);",
+        "INSERT INTO user_chat_groups (user_id, chatgroup_id) VALUES (4, 3);"
+    };
+
+    for (const QString &sql : demoUserChatGroups) {
+        executeSQL(db, sql);
+    }
+
+    // Create some demo messages with realistic timestamps
+    QDateTime baseTime = QDateTime::currentDateTime().addDays(-1);
+
+    // Group messages
+    QStringList demoGroupMessages = {
+        // General group messages
+        QString("INSERT INTO messages (sender_id, chatgroup_id, recipient_id, content, timestamp) "
+                "VALUES (1, 1, NULL, 'Hello everyone!', %1);")
+            .arg(toStoredTimestamp(baseTime)),
+
+        QString("INSERT INTO messages (sender_id, chatgroup_id, recipient_id, content, timestamp) "
+                "VALUES (2, 1, NULL, 'Hi Alice, how are you?', %1);")
+            .arg(toStoredTimestamp(baseTime.addSecs(60))),
+
+        QString("INSERT INTO messages (sender_id, chatgroup_id, recipient_id, content, timestamp) "
+                "VALUES (3, 1, NULL, 'Welcome to the general chat!', %1);")
+            .arg(toStoredTimestamp(baseTime.addSecs(120))),
+
+        // Tech Talk group messages
+        QString("INSERT INTO messages (sender_id, chatgroup_id, recipient_id, content, timestamp) "
+                "VALUES (1, 2, NULL, 'Anyone using the new Qt framework?', %1);")
+            .arg(toStoredTimestamp(baseTime.addSecs(180))),
+
+        QString("INSERT INTO messages (sender_id, chatgroup_id, recipient_id, content, timestamp) "
+                "VALUES (3, 2, NULL, 'Yes, I''m working on a project with it right now!', %1);")
+            .arg(toStoredTimestamp(baseTime.addSecs(240))),
+
+        // Coffee Break group messages
+        QString("INSERT INTO messages (sender_id, chatgroup_id, recipient_id, content, timestamp) "
+                "VALUES (2, 3, NULL, 'Anyone want to grab coffee later?', %1);")
+            .arg(toStoredTimestamp(baseTime.addSecs(300))),
+
+        QString("INSERT INTO messages (sender_id, chatgroup_id, recipient_id, content, timestamp) "
+                "VALUES (4, 3, NULL, 'I''m in! Around 3pm?', %1);")
+            .arg(toStoredTimestamp(baseTime.addSecs(360)))
+    };
+
+    for (const QString &sql : demoGroupMessages) {
+        executeSQL(db, sql);
+    }
+
+    // Direct messages between users
+    QStringList demoDirectMessages = {
+        // Alice to Bob
+        QString("INSERT INTO messages (sender_id, chatgroup_id, recipient_id, content, timestamp) "
+                "VALUES (1, NULL, 2, 'Hey Bob, do you have the meeting notes?', %1);")
+            .arg(toStoredTimestamp(baseTime.addSecs(420))),
+
+        // Bob to Alice
+        QString("INSERT INTO messages (sender_id, chatgroup_id, recipient_id, content, timestamp) "
+                "VALUES (2, NULL, 1, 'Yes, I''ll send them over shortly!', %1);")
+            .arg(toStoredTimestamp(baseTime.addSecs(480))),
+
+        // Charlie to Diana
+        QString("INSERT INTO messages (sender_id, chatgroup_id, recipient_id, content, timestamp) "
+                "VALUES (3, NULL, 4, 'Diana, are you joining the Tech Talk group?', %1);")
+            .arg(toStoredTimestamp(baseTime.addSecs(540))),
+
+        // Diana to Charlie
+        QString("INSERT INTO messages (sender_id, chatgroup_id, recipient_id, content, timestamp) "
+                "VALUES (4, NULL, 3, 'Not yet, but I''m thinking about it!', %1);")
+            .arg(toStoredTimestamp(baseTime.addSecs(600)))
+    };
+
+    for (const QString &sql : demoDirectMessages) {
+        executeSQL(db, sql);
+    }
+
+    db.commit();
+
+    // Close the database
+    db.close();
+    qDebug() << "Database setup completed successfully.";
+
+    return 0;
+}
+
+const QHash<QString, QStringList> &bulkLoadFields()
+{
+    static const QHash<QString, QStringList> fields = {
+        {"user", {"id", "name", "email", "password"}},
+        {"group", {"id", "name", "created_at", "created_by"}},
+        {"member", {"user_id", "group_id"}},
+        {"message", {"id", "sender_id", "group_id", "recipient_id", "content", "timestamp", "type"}},
+    };
+    return fields;
+}
+
+BulkInserter::BulkInserter(QSqlDatabase &db)
+    : user(db), group(db), member(db), message(db), inserted(0)
+{
+}
+
+bool BulkInserter::prepare()
+{
+    bool prepared =
+        user.prepare("INSERT INTO users (id, name, email, password) VALUES (?, ?, ?, ?)") &&
+        group.prepare("INSERT INTO chat_groups (id, name, created_at, created_by) "
+                      "VALUES (?, ?, COALESCE(?, datetime('now', 'localtime')), ?)") &&
+        member.prepare("INSERT INTO user_chat_groups (user_id, chatgroup_id) VALUES (?, ?)") &&
+        message.prepare("INSERT INTO messages (id, sender_id, chatgroup_id, recipient_id, content, timestamp, type) "
+                        "VALUES (?, ?, ?, ?, ?, COALESCE(?, CAST(strftime('%s', 'now') AS INTEGER) * 1000), "
+                        "COALESCE(?, 'message'))");
+    if (!prepared) {
+        qDebug() << "Failed to prepare bulk inserts";
+    }
+    return prepared;
+}
+
+bool BulkInserter::insert(const QString &kind, const QVariantList &values)
+{
+    QSqlQuery *query = kind == "message" ? &message
+                     : kind == "member"  ? &member
+                     : kind == "user"    ? &user
+                     : kind == "group"   ? &group
+                                         : nullptr;
+    if (!query) {
+        qDebug() << "Bulk load: unknown record kind" << kind;
+        return false;
+    }
+    const qsizetype columns = bulkLoadFields().value(kind).size();
+    if (values.size() > columns) {
+        qDebug() << "Bulk load: too many fields for" << kind;
+        return false;
+    }
+    for (qsizetype i = 0; i < columns; ++i) {
+        query->bindValue(int(i), i < values.size() ? values.at(i) : QVariant());
+    }
+    if (!query->exec()) {
+        qDebug() << "Bulk load: failed to insert" << kind << ":" << query->lastError().text();
+        return false;
+    }
+    if (++inserted % 100000 == 0) {
+        qDebug() << "Bulk load:" << inserted << "records";
+    }
+    return true;
+}
+
+namespace {
+
+// Reads one CSV record, which may span lines inside quotes. False at the end of the file.
+bool readCsvRecord(QFile &file, QList<QByteArray> &fields)
+{
+    fields.clear();
+    QByteArray field;
+    bool quoted = false;
+    bool read = false;
+    while (!file.atEnd()) {
+        const QByteArray line = file.readLine();
+        read = true;
+        for (qsizetype i = 0; i < line.size(); ++i) {
+            char c = line.at(i);
+            if (quoted) {
+                if (c != '"') {
+                    field.append(c);
+                } else if (i + 1 < line.size() && line.at(i + 1) == '"') {
+                    field.append('"');
+                    ++i;
+                } else {
+                    quoted = false;
+                }
+            } else if (c == '"') {
+                quoted = true;
+            } else if (c == ',') {
+                fields.append(field);
+                field.clear();
+            } else if (c != '\r' && c != '\n') {
+                field.append(c);
+            }
+        }
+        if (!quoted) {
+            break;
+        }
+    }
+    if (read) {
+        fields.append(field);
+    }
+    return read;
+}
+
+// JSON numbers arrive as doubles; whole ones are bound as integers
+QVariant bulkLoadValue(const QJsonValue &value)
+{
+    if (value.isDouble()) {
+        double number = value.toDouble();
+        if (number == double(qint64(number))) {
+            return qint64(number);
+        }
+        return number;
+    }
+    if (value.isString()) {
+        return value.toString();
+    }
+    if (value.isBool()) {
+        return int(value.toBool());
+    }
+    return QVariant();
+}
+
+// Streams the records of `file` into the inserter
+bool bulkLoadRecords(QFile &file, bool csv, BulkInserter &inserter)
+{
+    QList<QByteArray> csvFields;
+    qint64 record = 0;
+    while (!file.atEnd()) {
+        ++record;
+        QString kind;
+        QVariantList values;
+        if (csv) {
+            if (!readCsvRecord(file, csvFields)) {
+                break;
+            }
+            if (csvFields.size() == 1 && csvFields.first().isEmpty()) {
+                continue;
+            }
+            kind = QString::fromUtf8(csvFields.first());
+            for (qsizetype i = 1; i < csvFields.size(); ++i) {
+                values.append(csvFields.at(i).isEmpty() ? QVariant() : QVariant(QString::fromUtf8(csvFields.at(i))));
+            }
+        } else {
+            const QByteArray text = file.readLine().trimmed();
+            if (text.isEmpty()) {
+                continue;
+            }
+            QJsonParseError error;
+            const QJsonObject object = QJsonDocument::fromJson(text, &error).object();
+            if (error.error != QJsonParseError::NoError) {
+                qDebug() << "Bulk load: invalid JSON in record" << record << ":" << error.errorString();
+                return false;
+            }
+            kind = object.value("kind").toString();
+            for (const QString &name : bulkLoadFields().value(kind)) {
+                values.append(bulkLoadValue(object.value(name)));
+            }
+        }
+
+        if (!inserter.insert(kind, values)) {
+            qDebug() << "Bulk load: stopped at record" << record;
+            return false;
+        }
+    }
+    return true;
+}
+
+}
+
+int bulk_build_chat_db(const QString &databaseName, const std::function<bool(BulkInserter &)> &fill)
+{
+    if (checkDatabaseExists(databaseName)) {
+        qDebug() << "Chat database already exists, not bulk loading into it:" << databaseName;
+        return 1;
+    }
+
+    const QString connectionName = "quickchat_bulk_load";
+    QElapsedTimer timer;
+    timer.start();
+    bool ok = false;
+    {
+        QSqlDatabase db = QSqlDatabase::addDatabase("QSQLITE", connectionName);
+        db.setDatabaseName(databaseName);
+        if (!db.open()) {
+            qDebug() << "Can't open database:" << db.lastError().text();
+        } else {
+            // Nothing else may use the file until it is complete, so the load
+            // skips syncing and keeps its journal in memory
+            executeSQL(db, "PRAGMA locking_mode = EXCLUSIVE");
+            executeSQL(db, "PRAGMA journal_mode = MEMORY");
+            executeSQL(db, "PRAGMA synchronous = OFF");
+            executeSQL(db, "PRAGMA cache_size = -262144");   // 256 MiB
+            executeSQL(db, "PRAGMA temp_store = MEMORY");
+
+            createChatTables(db);
+            db.transaction();
+            {
+                BulkInserter inserter(db);
+                ok = inserter.prepare() && fill(inserter);
+                qDebug() << "Bulk load:" << inserter.count() << "records in" << timer.elapsed() << "ms";
+            }
+            if (ok) {
+                ok = db.commit();
+            } else {
+                db.rollback();
+            }
+
+            // Indexes, triggers and backfills, now that the rows are in
+            if (ok) {
+                qint64 loadMsecs = timer.elapsed();
+                ok = runSchemaMigrations(db);
+                qDebug() << "Bulk load: schema migrations took" << timer.elapsed() - loadMsecs << "ms";
+            }
+            db.close();
+        }
+    }
+    QSqlDatabase::removeDatabase(connectionName);
+
+    if (!ok) {
+        qDebug() << "Bulk load failed, removing" << databaseName;
+        QFile::remove(databaseName);
+        return 1;
+    }
+    return 0;
+}
+
+int bulk_load_chat_db(const QString &inputPath, const QString &databaseName)
+{
+    QFile file(inputPath);
+    if (!file.open(QIODevice::ReadOnly)) {
+        qDebug() << "Can't open bulk load input:" << inputPath << file.errorString();
+        return 1;
+    }
+    const bool csv = inputPath.endsWith(".csv", Qt::CaseInsensitive);
+    return bulk_build_chat_db(databaseName, [&](BulkInserter &inserter) {
+        return bulkLoadRecords(file, csv, inserter);
+    });
+}
+
+void executeSQL(QSqlDatabase &db, const QString &sql)
+{
+    QSqlQuery query(db);
+    if (!query.exec(sql))
+    {
+        qDebug() << "SQL error:" << query.lastError().text() << "\nQuery: " << sql;
+    }
+}
+
+bool checkDatabaseExists(const QString &dbName)
+{
+    // Check if the database file exists
+    return QFile::exists(dbName);
+}
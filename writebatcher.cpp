@@ -0,0 +1,92 @@
+#include "writebatcher.h"
+
+#include <algorithm>
+
+MessageWriteBatcher::MessageWriteBatcher(ChatDatabaseHandler *handler, QObject *parent)
+    : QObject(parent), handler(handler), flushTimer(this), maxRows(64), batchCount(0), rowCount(0)
+{
+    flushTimer.setSingleShot(true);
+    flushTimer.setInterval(5);
+    connect(&flushTimer, &QTimer::timeout, this, &MessageWriteBatcher::flush);
+}
+
+MessageWriteBatcher::~MessageWriteBatcher()
+{
+    // Anything still queued here is cancelled by the QPromise destructors
+    if (!pending.empty()) {
+        qDebug() << "Dropping" << pending.size() << "unwritten messages";
+    }
+}
+
+QFuture<qint64> MessageWriteBatcher::queueDirectMessage(const QString &sender, const QString &recipient,
+                                                        const QString &content)
+{
+    return enqueue({true, sender, recipient, -1, content, QString(), QPromise<qint64>()});
+}
+
+QFuture<qint64> MessageWriteBatcher::queueGroupMessage(const QString &sender, const QString &groupName,
+                                                       const QString &content, const QString &type)
+{
+    return enqueue({false, sender, groupName, -1, content, type, QPromise<qint64>()});
+}
+
+QFuture<qint64> MessageWriteBatcher::queueGroupMessage(const QString &sender, int groupId,
+                                                       const QString &content, const QString &type)
+{
+    return enqueue({false, sender, QString(), groupId, content, type, QPromise<qint64>()});
+}
+
+QFuture<qint64> MessageWriteBatcher::enqueue(PendingMessage &&message)
+{
+    QFuture<qint64> future = message.promise.future();
+    message.promise.start();
+    pending.push_back(std::move(message));
+
+    if (static_cast<int>(pending.size()) >= maxRows) {
+        flush();
+    } else if (!flushTimer.isActive()) {
+        // The delay is measured from the first message of the batch
+        flushTimer.start();
+    }
+    return future;
+}
+
+void MessageWriteBatcher::flush()
+{
+    flushTimer.stop();
+    if (pending.empty()) {
+        return;
+    }
+
+    std::vector<PendingMessage> batch;
+    batch.swap(pending);
+
+    // A failed insert only fails its own statement; the rest of the batch still commits
+    bool inTransaction = handler->beginTransaction();
+
+    std::vector<qint64> ids;
+    ids.reserve(batch.size());
+    for (const PendingMessage &message : batch) {
+        if (message.direct) {
+            ids.push_back(handler->insertDirectMessage(message.sender, message.target, message.content));
+        } else if (message.groupId >= 0) {
+            ids.push_back(handler->insertGroupMessage(message.sender, message.groupId, message.content, message.type));
+        } else {
+            ids.push_back(handler->insertGroupMessage(message.sender, message.target, message.content, message.type));
+        }
+    }
+
+    if (inTransaction && !handler->commitTransaction()) {
+        handler->rollbackTransaction();
+        std::fill(ids.begin(), ids.end(), -1);
+    }
+
+    ++batchCount;
+    rowCount += batch.size();
+
+    // Results go out only after the commit, so a reader woken by them sees the rows
+    for (size_t i = 0; i < batch.size(); ++i) {
+        batch[i].promise.addResult(ids[i]);
+        batch[i].promise.finish();
+    }
+}
@@ -0,0 +1,64 @@
+#ifndef WRITEBATCHER_H
+#define WRITEBATCHER_H
+
+#include <QObject>
+#include <QTimer>
+#include <QFuture>
+#include <QPromise>
+#include <vector>
+
+#include "chatdbhandler.h"
+
+// Group commit for message inserts. Inserts queued within a few
+// milliseconds of each other (or until maxRows are pending) are written
+// in a single transaction, so a burst costs one fsync instead of one per
+// message. Each caller still gets its own result: the new message id,
+// or -1 if that insert (or the batch commit) failed.
+//
+// Lives on the handler's thread; queue and flush must be called there.
+class MessageWriteBatcher : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit MessageWriteBatcher(ChatDatabaseHandler *handler, QObject *parent = nullptr);
+    ~MessageWriteBatcher();
+
+    QFuture<qint64> queueDirectMessage(const QString &sender, const QString &recipient, const QString &content);
+    QFuture<qint64> queueGroupMessage(const QString &sender, const QString &groupName,
+                                      const QString &content, const QString &type = "text");
+    QFuture<qint64> queueGroupMessage(const QString &sender, int groupId,
+                                      const QString &content, const QString &type = "text");
+
+    void setMaxDelay(int milliseconds) { flushTimer.setInterval(milliseconds); }
+    void setMaxRows(int rows) { maxRows = qMax(1, rows); }
+
+    quint64 committedBatches() const { return batchCount; }
+    quint64 committedRows() const { return rowCount; }
+
+public slots:
+    // Writes everything pending now
+    void flush();
+
+private:
+    struct PendingMessage {
+        bool direct;
+        QString sender;
+        QString target; // recipient email or group name
+        int groupId;    // used instead of target when >= 0
+        QString content;
+        QString type;
+        QPromise<qint64> promise;
+    };
+
+    ChatDatabaseHandler *handler;
+    QTimer flushTimer;
+    std::vector<PendingMessage> pending;
+    int maxRows;
+    quint64 batchCount;
+    quint64 rowCount;
+
+    QFuture<qint64> enqueue(PendingMessage &&message);
+};
+
+#endif // WRITEBATCHER_H